@@ -0,0 +1,312 @@
+#include "./byte_set.h"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#    define FSV_X86_DISPATCH 1
+#    include <immintrin.h>
+#endif
+
+namespace {
+    // Scalar kernels: one table lookup per byte, no predicate call
+    auto count_scalar(const fsv::byte_set &set, const char *first, const char *last) -> std::size_t {
+        std::size_t total = 0;
+        for (; first != last; ++first) {
+            total += set.contains(*first) ? 1u : 0u;
+        }
+        return total;
+    }
+
+    auto find_first_scalar(const fsv::byte_set &set, const char *first, const char *last) -> const char * {
+        while (first != last and not set.contains(*first)) {
+            ++first;
+        }
+        return first;
+    }
+
+    auto find_last_scalar(const fsv::byte_set &set, const char *first, const char *last) -> const char * {
+        for (auto position = last; position != first;) {
+            --position;
+            if (set.contains(*position)) {
+                return position;
+            }
+        }
+        return last;
+    }
+
+    auto compact_scalar(const fsv::byte_set &set, const char *first, const char *last, char *out, char *)
+        -> char * {
+        for (; first != last; ++first) {
+            if (set.contains(*first)) {
+                *out++ = *first;
+            }
+        }
+        return out;
+    }
+
+#ifdef FSV_X86_DISPATCH
+    /*
+     * Exact 256-bit classification with three pshufb per vector:
+     *   row   = lo_rows[b & 15] when b < 0x80, hi_rows[b & 15] otherwise
+     *           (pshufb zeroes lanes whose index has bit 7 set, so b and b ^ 0x80 pick one each)
+     *   bit   = 1 << ((b >> 4) & 7)
+     *   match = (row & bit) == bit
+     */
+    __attribute__((target("ssse3"))) auto classify_16(__m128i bytes, __m128i lo_rows, __m128i hi_rows)
+        -> __m128i {
+        const auto high_bit = _mm_set1_epi8(static_cast<char>(0x80));
+        const auto nibble = _mm_set1_epi8(0x0F);
+        const auto bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, static_cast<char>(128),
+                                        1, 2, 4, 8, 16, 32, 64, static_cast<char>(128));
+        auto row = _mm_or_si128(_mm_shuffle_epi8(lo_rows, bytes),
+                                _mm_shuffle_epi8(hi_rows, _mm_xor_si128(bytes, high_bit)));
+        auto bit = _mm_shuffle_epi8(bits, _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble));
+        return _mm_cmpeq_epi8(_mm_and_si128(row, bit), bit);
+    }
+
+    __attribute__((target("ssse3"))) auto match_mask_16(const char *p, __m128i lo_rows, __m128i hi_rows)
+        -> unsigned {
+        auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        return static_cast<unsigned>(_mm_movemask_epi8(classify_16(bytes, lo_rows, hi_rows)));
+    }
+
+    __attribute__((target("avx2"))) auto classify_32(__m256i bytes, __m256i lo_rows, __m256i hi_rows)
+        -> __m256i {
+        const auto high_bit = _mm256_set1_epi8(static_cast<char>(0x80));
+        const auto nibble = _mm256_set1_epi8(0x0F);
+        const auto bits = _mm256_setr_epi8(1, 2, 4, 8, 16, 32, 64, static_cast<char>(128),
+                                           1, 2, 4, 8, 16, 32, 64, static_cast<char>(128),
+                                           1, 2, 4, 8, 16, 32, 64, static_cast<char>(128),
+                                           1, 2, 4, 8, 16, 32, 64, static_cast<char>(128));
+        auto row = _mm256_or_si256(_mm256_shuffle_epi8(lo_rows, bytes),
+                                   _mm256_shuffle_epi8(hi_rows, _mm256_xor_si256(bytes, high_bit)));
+        auto bit = _mm256_shuffle_epi8(bits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), nibble));
+        return _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+    }
+
+    __attribute__((target("avx2"))) auto match_mask_32(const char *p, __m256i lo_rows, __m256i hi_rows)
+        -> std::uint32_t {
+        auto bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(classify_32(bytes, lo_rows, hi_rows)));
+    }
+
+    __attribute__((target("ssse3"))) auto load_rows_16(const fsv::byte_set &set, int half) -> __m128i {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(set.lookup_table().data() + 16 * half));
+    }
+
+    __attribute__((target("avx2"))) auto load_rows_32(const fsv::byte_set &set, int half) -> __m256i {
+        return _mm256_broadcastsi128_si256(load_rows_16(set, half));
+    }
+
+    __attribute__((target("ssse3"))) auto count_ssse3(const fsv::byte_set &set, const char *first, const char *last)
+        -> std::size_t {
+        const auto lo_rows = load_rows_16(set, 0);
+        const auto hi_rows = load_rows_16(set, 1);
+        std::size_t total = 0;
+        for (; last - first >= 16; first += 16) {
+            total += static_cast<std::size_t>(std::popcount(match_mask_16(first, lo_rows, hi_rows)));
+        }
+        return total + count_scalar(set, first, last);
+    }
+
+    __attribute__((target("ssse3"))) auto find_first_ssse3(const fsv::byte_set &set, const char *first,
+                                                           const char *last) -> const char * {
+        const auto lo_rows = load_rows_16(set, 0);
+        const auto hi_rows = load_rows_16(set, 1);
+        for (; last - first >= 16; first += 16) {
+            if (auto mask = match_mask_16(first, lo_rows, hi_rows)) {
+                return first + std::countr_zero(mask);
+            }
+        }
+        return find_first_scalar(set, first, last);
+    }
+
+    __attribute__((target("ssse3"))) auto find_last_ssse3(const fsv::byte_set &set, const char *first,
+                                                          const char *last) -> const char * {
+        const auto lo_rows = load_rows_16(set, 0);
+        const auto hi_rows = load_rows_16(set, 1);
+        auto end = last;
+        for (; end - first >= 16; end -= 16) {
+            if (auto mask = match_mask_16(end - 16, lo_rows, hi_rows)) {
+                // mask has 16 significant bits in a 32-bit unsigned
+                return end + 15 - std::countl_zero(mask);
+            }
+        }
+        auto found = find_last_scalar(set, first, end);
+        return found == end ? last : found;
+    }
+
+    __attribute__((target("avx2,popcnt"))) auto count_avx2(const fsv::byte_set &set, const char *first,
+                                                           const char *last) -> std::size_t {
+        const auto lo_rows = load_rows_32(set, 0);
+        const auto hi_rows = load_rows_32(set, 1);
+        std::size_t total = 0;
+        for (; last - first >= 64; first += 64) {
+            auto low = std::uint64_t{match_mask_32(first, lo_rows, hi_rows)};
+            auto high = std::uint64_t{match_mask_32(first + 32, lo_rows, hi_rows)};
+            total += static_cast<std::size_t>(std::popcount(low | (high << 32)));
+        }
+        for (; last - first >= 32; first += 32) {
+            total += static_cast<std::size_t>(std::popcount(match_mask_32(first, lo_rows, hi_rows)));
+        }
+        return total + count_scalar(set, first, last);
+    }
+
+    __attribute__((target("avx2"))) auto find_first_avx2(const fsv::byte_set &set, const char *first,
+                                                              const char *last) -> const char * {
+        const auto lo_rows = load_rows_32(set, 0);
+        const auto hi_rows = load_rows_32(set, 1);
+        for (; last - first >= 32; first += 32) {
+            if (auto mask = match_mask_32(first, lo_rows, hi_rows)) {
+                return first + std::countr_zero(mask);
+            }
+        }
+        return find_first_scalar(set, first, last);
+    }
+
+    __attribute__((target("avx2"))) auto find_last_avx2(const fsv::byte_set &set, const char *first,
+                                                               const char *last) -> const char * {
+        const auto lo_rows = load_rows_32(set, 0);
+        const auto hi_rows = load_rows_32(set, 1);
+        auto end = last;
+        for (; end - first >= 32; end -= 32) {
+            if (auto mask = match_mask_32(end - 32, lo_rows, hi_rows)) {
+                return end - 1 - std::countl_zero(mask);
+            }
+        }
+        auto found = find_last_scalar(set, first, end);
+        return found == end ? last : found;
+    }
+
+    /*
+     * Left-pack table: entry m lists, in order, the positions of the set bits of the
+     * 8-bit mask m, so pshufb with it moves the selected bytes of an 8-byte group to the front.
+     */
+    constexpr auto make_pack_table() -> std::array<std::array<std::uint8_t, 8>, 256> {
+        auto table = std::array<std::array<std::uint8_t, 8>, 256>{};
+        for (unsigned mask = 0; mask < 256; ++mask) {
+            std::size_t out = 0;
+            for (unsigned bit = 0; bit < 8; ++bit) {
+                if (mask & (1u << bit)) {
+                    table[mask][out++] = static_cast<std::uint8_t>(bit);
+                }
+            }
+        }
+        return table;
+    }
+
+    constexpr auto pack_table = make_pack_table();
+
+    // Packs the bytes of in[0, 8) selected by mask to out, never writing at or past out_last
+    __attribute__((target("ssse3"))) auto pack_8(const char *in, unsigned mask, char *out, char *out_last)
+        -> char * {
+        const auto count = static_cast<std::size_t>(std::popcount(mask));
+        auto bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in));
+        auto control = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(pack_table[mask].data()));
+        auto packed = _mm_shuffle_epi8(bytes, control);
+        if (out_last - out >= 8) {
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(out), packed);
+        }
+        else {
+            char spill[16];
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(spill), packed);
+            std::memcpy(out, spill, count);
+        }
+        return out + count;
+    }
+
+    __attribute__((target("ssse3"))) auto compact_ssse3(const fsv::byte_set &set, const char *first,
+                                                        const char *last, char *out, char *out_last) -> char * {
+        const auto lo_rows = load_rows_16(set, 0);
+        const auto hi_rows = load_rows_16(set, 1);
+        for (; last - first >= 16; first += 16) {
+            auto mask = match_mask_16(first, lo_rows, hi_rows);
+            if (mask == 0xFFFFu) {
+                std::memcpy(out, first, 16);
+                out += 16;
+            }
+            else if (mask != 0) {
+                out = pack_8(first, mask & 0xFFu, out, out_last);
+                out = pack_8(first + 8, mask >> 8, out, out_last);
+            }
+        }
+        return compact_scalar(set, first, last, out, out_last);
+    }
+
+    __attribute__((target("avx2,popcnt"))) auto compact_avx2(const fsv::byte_set &set, const char *first,
+                                                             const char *last, char *out, char *out_last)
+        -> char * {
+        const auto lo_rows = load_rows_32(set, 0);
+        const auto hi_rows = load_rows_32(set, 1);
+        for (; last - first >= 32; first += 32) {
+            auto mask = match_mask_32(first, lo_rows, hi_rows);
+            if (mask == 0xFFFFFFFFu) {
+                std::memcpy(out, first, 32);
+                out += 32;
+            }
+            else if (mask != 0) {
+                for (unsigned group = 0; group < 4; ++group) {
+                    out = pack_8(first + 8 * group, (mask >> (8 * group)) & 0xFFu, out, out_last);
+                }
+            }
+        }
+        return compact_scalar(set, first, last, out, out_last);
+    }
+#endif
+
+    auto detect_kernels() -> std::vector<fsv::detail::byte_set_kernels> {
+        auto found = std::vector<fsv::detail::byte_set_kernels>{};
+#ifdef FSV_X86_DISPATCH
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("popcnt")) {
+            found.push_back({"avx2", count_avx2, find_first_avx2, find_last_avx2, compact_avx2});
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            found.push_back({"ssse3", count_ssse3, find_first_ssse3, find_last_ssse3, compact_ssse3});
+        }
+#endif
+        found.push_back({"scalar", count_scalar, find_first_scalar, find_last_scalar, compact_scalar});
+        return found;
+    }
+
+    // Picked once, on first use
+    auto active_kernels() -> const fsv::detail::byte_set_kernels & {
+        return fsv::detail::available_byte_set_kernels().front();
+    }
+
+    // Below this many bytes the scalar loop wins over dispatch and vector setup
+    constexpr std::ptrdiff_t vector_threshold = 16;
+}
+
+auto fsv::detail::available_byte_set_kernels() -> const std::vector<byte_set_kernels> & {
+    static const auto available = detect_kernels();
+    return available;
+}
+
+auto fsv::byte_set::count(const char *first, const char *last) const -> std::size_t {
+    if (last - first < vector_threshold) {
+        return count_scalar(*this, first, last);
+    }
+    return active_kernels().count(*this, first, last);
+}
+
+auto fsv::byte_set::find_first(const char *first, const char *last) const -> const char * {
+    if (last - first < vector_threshold) {
+        return find_first_scalar(*this, first, last);
+    }
+    return active_kernels().find_first(*this, first, last);
+}
+
+auto fsv::byte_set::find_last(const char *first, const char *last) const -> const char * {
+    if (last - first < vector_threshold) {
+        return find_last_scalar(*this, first, last);
+    }
+    return active_kernels().find_last(*this, first, last);
+}
+
+auto fsv::byte_set::compact(const char *first, const char *last, char *out, char *out_last) const -> char * {
+    if (last - first < vector_threshold) {
+        return compact_scalar(*this, first, last, out, out_last);
+    }
+    return active_kernels().compact(*this, first, last, out, out_last);
+}
@@ -0,0 +1,205 @@
+#ifndef COMP6771_ASS2_BYTE_SET_H
+#define COMP6771_ASS2_BYTE_SET_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace fsv {
+	/**
+	 * A predicate that is a pure function of one byte, stored as a 256-bit table.
+	 *
+	 * Views recognise it, both as basic_filtered_string_view<byte_set> and when it sits
+	 * inside the std::function of a filtered_string_view, and scan with table lookups
+	 * (see count/find_first/find_last) instead of calling an opaque predicate per byte.
+	 *
+	 * The 256 bits are laid out by nibble so SIMD kernels can use the table as is:
+	 * byte b is bit (b >> 4) & 7 of table[(b & 15) + 16 * (b >> 7)], i.e. the first
+	 * 16 bytes cover high nibbles 0-7 and the last 16 bytes high nibbles 8-15, both
+	 * indexed by the low nibble. That is the pshufb lookup the kernels do 16 or 32
+	 * bytes at a time.
+	 *
+	 *   auto no_space = ~fsv::byte_set::of(" \t\r\n");
+	 *   auto hex = fsv::byte_set::range('0', '9') | fsv::byte_set::range('a', 'f');
+	 */
+	class byte_set {
+	public:
+		/**
+		 * The empty set
+		 */
+		constexpr byte_set() = default;
+
+		static constexpr auto all() -> byte_set {
+			return ~byte_set{};
+		}
+
+		/**
+		 * Every char listed in chars, e.g. byte_set::of("aeiou")
+		 */
+		static constexpr auto of(std::string_view chars) -> byte_set {
+			auto set = byte_set{};
+			for (auto c : chars) {
+				set.insert(c);
+			}
+			return set;
+		}
+
+		/**
+		 * Every byte in [first, last], compared as unsigned bytes
+		 */
+		static constexpr auto range(char first, char last) -> byte_set {
+			auto set = byte_set{};
+			for (auto b = static_cast<unsigned>(static_cast<unsigned char>(first));
+			     b <= static_cast<unsigned char>(last);
+			     ++b)
+			{
+				set.insert(static_cast<char>(b));
+			}
+			return set;
+		}
+
+		/**
+		 * Tabulates any byte predicate, e.g. an fsv::filter, by evaluating it once on
+		 * each of the 256 byte values. Only meaningful for predicates that depend on the
+		 * char alone: one that looks at its address (like substr's) cannot be tabulated.
+		 */
+		template<typename Pred>
+		static constexpr auto from(const Pred &pred) -> byte_set {
+			auto set = byte_set{};
+			for (unsigned b = 0; b < 256; ++b) {
+				const auto c = static_cast<char>(b);
+				if (pred(c)) {
+					set.insert(c);
+				}
+			}
+			return set;
+		}
+
+		constexpr auto insert(char c) -> byte_set & {
+			const auto b = static_cast<unsigned char>(c);
+			table[slot(b)] = static_cast<std::uint8_t>(table[slot(b)] | mask(b));
+			return *this;
+		}
+
+		constexpr auto contains(char c) const -> bool {
+			const auto b = static_cast<unsigned char>(c);
+			return (table[slot(b)] & mask(b)) != 0;
+		}
+
+		constexpr auto operator()(const char &c) const -> bool {
+			return contains(c);
+		}
+
+		/**
+		 * Number of byte values in the set
+		 */
+		constexpr auto count() const -> std::size_t {
+			std::size_t total = 0;
+			for (auto entry : table) {
+				total += static_cast<std::size_t>(std::popcount(entry));
+			}
+			return total;
+		}
+
+		constexpr auto is_all() const -> bool {
+			return *this == all();
+		}
+
+		constexpr auto is_empty() const -> bool {
+			return *this == byte_set{};
+		}
+
+		friend constexpr auto operator|(byte_set lhs, const byte_set &rhs) -> byte_set {
+			for (std::size_t i = 0; i < lhs.table.size(); ++i) {
+				lhs.table[i] = static_cast<std::uint8_t>(lhs.table[i] | rhs.table[i]);
+			}
+			return lhs;
+		}
+
+		friend constexpr auto operator&(byte_set lhs, const byte_set &rhs) -> byte_set {
+			for (std::size_t i = 0; i < lhs.table.size(); ++i) {
+				lhs.table[i] = static_cast<std::uint8_t>(lhs.table[i] & rhs.table[i]);
+			}
+			return lhs;
+		}
+
+		friend constexpr auto operator~(byte_set set) -> byte_set {
+			for (auto &entry : set.table) {
+				entry = static_cast<std::uint8_t>(~entry);
+			}
+			return set;
+		}
+
+		friend constexpr auto operator==(const byte_set &lhs, const byte_set &rhs) -> bool = default;
+
+		// Bulk scanning kernels over [first, last).
+		// AVX2 or SSSE3 when the CPU has them (checked once at runtime), scalar otherwise.
+
+		/**
+		 * Number of bytes in [first, last) that are in the set
+		 */
+		auto count(const char *first, const char *last) const -> std::size_t;
+
+		/**
+		 * First position in [first, last) whose byte is in the set, or last
+		 */
+		auto find_first(const char *first, const char *last) const -> const char *;
+
+		/**
+		 * Last position in [first, last) whose byte is in the set, or last if there is none
+		 */
+		auto find_last(const char *first, const char *last) const -> const char *;
+
+		/**
+		 * Copies the bytes of [first, last) that are in the set to out, in order, and
+		 * returns the end of the output. Left-packs with pshufb tables.
+		 * Requires out_last - out >= count(first, last);
+		 * nothing is written at or past out_last.
+		 */
+		auto compact(const char *first, const char *last, char *out, char *out_last) const -> char *;
+
+		/**
+		 * The raw nibble-indexed table described above
+		 */
+		constexpr auto lookup_table() const -> const std::array<std::uint8_t, 32> & {
+			return table;
+		}
+
+	private:
+		static constexpr auto slot(unsigned char b) -> std::size_t {
+			return static_cast<std::size_t>((b & 0x0Fu) | ((b >> 7) << 4));
+		}
+
+		static constexpr auto mask(unsigned char b) -> std::uint8_t {
+			return static_cast<std::uint8_t>(1u << ((b >> 4) & 0x07u));
+		}
+
+		std::array<std::uint8_t, 32> table{};
+	};
+
+	namespace detail {
+		/**
+		 * One implementation of the bulk kernels of byte_set. The member functions
+		 * call the first entry of available_byte_set_kernels(), for inputs of at
+		 * least 16 bytes; shorter ones always take the scalar kernels.
+		 */
+		struct byte_set_kernels {
+			const char *name;
+			std::size_t (*count)(const byte_set &, const char *, const char *);
+			const char *(*find_first)(const byte_set &, const char *, const char *);
+			const char *(*find_last)(const byte_set &, const char *, const char *);
+			char *(*compact)(const byte_set &, const char *, const char *, char *, char *);
+		};
+
+		/**
+		 * Every kernel set this CPU can run, fastest first, ending with the scalar
+		 * one. Lets tests check each of them, not only the one dispatch picks.
+		 */
+		auto available_byte_set_kernels() -> const std::vector<byte_set_kernels> &;
+	} // namespace detail
+} // namespace fsv
+
+#endif // COMP6771_ASS2_BYTE_SET_H
@@ -0,0 +1,168 @@
+#include "./byte_set.h"
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+TEST_CASE("Byte set construction") {
+	SECTION("Empty and all") {
+		const auto none = fsv::byte_set{};
+		const auto all = fsv::byte_set::all();
+		REQUIRE(none.is_empty());
+		REQUIRE(none.count() == 0);
+		REQUIRE(all.is_all());
+		REQUIRE(all.count() == 256);
+		for (char c = std::numeric_limits<char>::min(); c != std::numeric_limits<char>::max(); c++) {
+			REQUIRE(!none(c));
+			REQUIRE(all(c));
+		}
+	}
+
+	SECTION("Character list") {
+		const auto vowels = fsv::byte_set::of("aeiou");
+		REQUIRE(vowels.count() == 5);
+		REQUIRE(vowels('e'));
+		REQUIRE(!vowels('b'));
+		REQUIRE(!vowels('\0'));
+	}
+
+	SECTION("Range covers both ends and high bytes") {
+		const auto digits = fsv::byte_set::range('0', '9');
+		REQUIRE(digits.count() == 10);
+		REQUIRE(digits('0'));
+		REQUIRE(digits('9'));
+		REQUIRE(!digits('/'));
+		REQUIRE(!digits(':'));
+
+		const auto high = fsv::byte_set::range('\x80', '\xff');
+		REQUIRE(high.count() == 128);
+		REQUIRE(high('\xff'));
+		REQUIRE(!high('\x7f'));
+		REQUIRE(fsv::byte_set::range('z', 'a').is_empty());
+	}
+
+	SECTION("Tabulated from a predicate") {
+		const auto upper = fsv::byte_set::from([](const char &c) { return c >= 'A' && c <= 'Z'; });
+		REQUIRE(upper == fsv::byte_set::range('A', 'Z'));
+	}
+
+	SECTION("Set algebra") {
+		const auto hex = fsv::byte_set::range('0', '9') | fsv::byte_set::range('a', 'f');
+		REQUIRE(hex.count() == 16);
+		REQUIRE((hex & fsv::byte_set::range('a', 'z')) == fsv::byte_set::range('a', 'f'));
+		REQUIRE((~hex).count() == 240);
+		REQUIRE(!(~hex)('c'));
+	}
+
+	SECTION("Usable at compile time") {
+		constexpr auto space = fsv::byte_set::of(" \t\n");
+		STATIC_REQUIRE(space(' '));
+		STATIC_REQUIRE(!space('x'));
+		STATIC_REQUIRE(space.count() == 3);
+	}
+}
+
+TEST_CASE("Byte set scanning") {
+	const auto text = std::string("the quick brown fox jumps over the lazy dog");
+	const auto first = text.data();
+	const auto last = text.data() + text.size();
+	const auto vowels = fsv::byte_set::of("aeiou");
+
+	SECTION("count") {
+		REQUIRE(vowels.count(first, last) == 11);
+		REQUIRE(vowels.count(first, first) == 0);
+		REQUIRE(fsv::byte_set::all().count(first, last) == text.size());
+	}
+
+	SECTION("find_first") {
+		REQUIRE(vowels.find_first(first, last) == first + 2);
+		REQUIRE(vowels.find_first(first + 3, last) == first + 5);
+		REQUIRE(fsv::byte_set::of("!").find_first(first, last) == last);
+	}
+
+	SECTION("find_last") {
+		REQUIRE(vowels.find_last(first, last) == first + text.rfind('o'));
+		REQUIRE(vowels.find_last(first, first + 2) == first + 2);
+		REQUIRE(fsv::byte_set::of("!").find_last(first, last) == last);
+	}
+}
+
+TEST_CASE("Byte set kernels agree with a per-byte reference") {
+	// Long buffers with every byte value, walked at odd offsets so vector loops,
+	// unrolled loops and scalar tails all get exercised
+	auto buffer = std::string(1000, '\0');
+	auto state = std::uint32_t{2463534242u};
+	for (auto &c : buffer) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		c = static_cast<char>(state & 0xFFu);
+	}
+
+	const auto sets = std::vector<fsv::byte_set>{
+	    fsv::byte_set{},
+	    fsv::byte_set::all(),
+	    fsv::byte_set::of("aeiou"),
+	    fsv::byte_set::range('\x80', '\xff'),
+	    fsv::byte_set::of("\x01\x7f\x80\xfe"),
+	    ~fsv::byte_set::of(std::string_view("\0", 1)),
+	    fsv::byte_set::from([](const char &c) { return (static_cast<unsigned char>(c) * 7u) % 3u == 0; }),
+	};
+
+	for (const auto &set : sets) {
+		for (std::size_t offset = 0; offset < 40; offset += 3) {
+			for (std::size_t length : {0u, 1u, 15u, 16u, 17u, 31u, 32u, 33u, 63u, 64u, 65u, 200u, 959u}) {
+				const auto first = buffer.data() + offset;
+				const auto last = first + length;
+
+				auto expected_count = std::size_t{0};
+				auto expected_compact = std::string{};
+				const char *expected_first = last;
+				const char *expected_last = last;
+				for (auto p = first; p != last; ++p) {
+					if (set(*p)) {
+						++expected_count;
+						expected_compact.push_back(*p);
+						if (expected_first == last) {
+							expected_first = p;
+						}
+						expected_last = p;
+					}
+				}
+				REQUIRE(set.count(first, last) == expected_count);
+				REQUIRE(set.find_first(first, last) == expected_first);
+				REQUIRE(set.find_last(first, last) == expected_last);
+
+				// Every kernel the CPU supports, not only the dispatched one, and at
+				// every length, not only those above the dispatch threshold
+				for (const auto &kernel : fsv::detail::available_byte_set_kernels()) {
+					INFO(kernel.name << " kernel, offset " << offset << ", length " << length);
+					REQUIRE(kernel.count(set, first, last) == expected_count);
+					REQUIRE(kernel.find_first(set, first, last) == expected_first);
+					REQUIRE(kernel.find_last(set, first, last) == expected_last);
+
+					// Exactly sized output: the kernel must not write past it
+					auto compacted = std::vector<char>(expected_count);
+					auto out = compacted.data();
+					REQUIRE(kernel.compact(set, first, last, out, out + expected_count) == out + expected_count);
+					REQUIRE(std::string(compacted.begin(), compacted.end()) == expected_compact);
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("Byte set kernel table") {
+	const auto &kernels = fsv::detail::available_byte_set_kernels();
+	REQUIRE(not kernels.empty());
+	CHECK(std::string(kernels.back().name) == "scalar");
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+	__builtin_cpu_init();
+	const auto listed = [&kernels](std::string_view name) {
+		return std::any_of(kernels.begin(), kernels.end(), [name](const auto &kernel) { return kernel.name == name; });
+	};
+	CHECK(listed("avx2") == (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("popcnt")));
+	CHECK(listed("ssse3") == static_cast<bool>(__builtin_cpu_supports("ssse3")));
+#endif
+}
@@ -0,0 +1,129 @@
+#include "./content_hash.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+    constexpr std::uint64_t prime_1 = 0x9E3779B185EBCA87u;
+    constexpr std::uint64_t prime_2 = 0xC2B2AE3D27D4EB4Fu;
+    constexpr std::uint64_t prime_3 = 0x165667B19E3779F9u;
+    constexpr std::uint64_t prime_4 = 0x85EBCA77C2B2AE63u;
+    constexpr std::uint64_t prime_5 = 0x27D4EB2F165667C5u;
+
+    // Little-endian loads, as XXH64 is defined
+    auto read_64(const char *bytes) -> std::uint64_t {
+        std::uint64_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        if constexpr (std::endian::native == std::endian::big) {
+            value = __builtin_bswap64(value);
+        }
+        return value;
+    }
+
+    auto read_32(const char *bytes) -> std::uint64_t {
+        std::uint32_t value;
+        std::memcpy(&value, bytes, sizeof(value));
+        if constexpr (std::endian::native == std::endian::big) {
+            value = __builtin_bswap32(value);
+        }
+        return value;
+    }
+
+    auto lane_round(std::uint64_t lane, std::uint64_t input) -> std::uint64_t {
+        lane += input * prime_2;
+        lane = std::rotl(lane, 31);
+        return lane * prime_1;
+    }
+
+    auto merge_round(std::uint64_t hash, std::uint64_t lane) -> std::uint64_t {
+        hash ^= lane_round(0, lane);
+        return hash * prime_1 + prime_4;
+    }
+}
+
+fsv::content_hasher::content_hasher(std::uint64_t seed)
+    : seed(seed),
+      lanes{seed + prime_1 + prime_2, seed + prime_2, seed, seed - prime_1}
+{
+
+}
+
+auto fsv::content_hasher::consume_stripe(const char *stripe) -> void {
+    for (std::size_t lane = 0; lane < lanes.size(); ++lane) {
+        lanes[lane] = lane_round(lanes[lane], read_64(stripe + 8 * lane));
+    }
+}
+
+auto fsv::content_hasher::update(std::string_view bytes) -> void {
+    total += bytes.size();
+    auto input = bytes.data();
+    auto remaining = bytes.size();
+
+    if (pending_size != 0) {
+        const auto fill = std::min(remaining, stripe_size - pending_size);
+        std::memcpy(pending.data() + pending_size, input, fill);
+        pending_size += fill;
+        input += fill;
+        remaining -= fill;
+        if (pending_size < stripe_size) {
+            return;
+        }
+        consume_stripe(pending.data());
+        pending_size = 0;
+    }
+
+    // Whole stripes straight from the input, the four lanes are independent
+    for (; remaining >= stripe_size; input += stripe_size, remaining -= stripe_size) {
+        consume_stripe(input);
+    }
+
+    if (remaining != 0) {
+        std::memcpy(pending.data(), input, remaining);
+        pending_size = remaining;
+    }
+}
+
+auto fsv::content_hasher::digest() const -> std::uint64_t {
+    std::uint64_t hash;
+    if (total >= stripe_size) {
+        hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+        for (auto lane : lanes) {
+            hash = merge_round(hash, lane);
+        }
+    }
+    else {
+        hash = seed + prime_5;
+    }
+    hash += total;
+
+    auto tail = pending.data();
+    auto remaining = pending_size;
+    for (; remaining >= 8; tail += 8, remaining -= 8) {
+        hash ^= lane_round(0, read_64(tail));
+        hash = std::rotl(hash, 27) * prime_1 + prime_4;
+    }
+    if (remaining >= 4) {
+        hash ^= read_32(tail) * prime_1;
+        hash = std::rotl(hash, 23) * prime_2 + prime_3;
+        tail += 4;
+        remaining -= 4;
+    }
+    for (; remaining > 0; ++tail, --remaining) {
+        hash ^= static_cast<unsigned char>(*tail) * prime_5;
+        hash = std::rotl(hash, 11) * prime_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= prime_2;
+    hash ^= hash >> 29;
+    hash *= prime_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+auto fsv::content_hash(std::string_view bytes) -> std::size_t {
+    auto hasher = content_hasher{};
+    hasher.update(bytes);
+    return static_cast<std::size_t>(hasher.digest());
+}
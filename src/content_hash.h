@@ -0,0 +1,53 @@
+#ifndef COMP6771_ASS2_CONTENT_HASH_H
+#define COMP6771_ASS2_CONTENT_HASH_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace fsv {
+	/**
+	 * Streaming 64-bit hash of a byte sequence, using the XXH64 algorithm.
+	 *
+	 * The digest only depends on the concatenation of everything passed to update(),
+	 * not on where it was split, so a view can feed its passing chars a chunk at a
+	 * time and get the same value as content_hash() of the materialised string.
+	 *
+	 *   auto hasher = fsv::content_hasher{};
+	 *   hasher.update("hello ");
+	 *   hasher.update("world");
+	 *   hasher.digest() == fsv::content_hash("hello world");
+	 */
+	class content_hasher {
+	public:
+		explicit content_hasher(std::uint64_t seed = 0);
+
+		auto update(std::string_view bytes) -> void;
+
+		/**
+		 * Hash of the bytes seen so far. Does not change the state, so more bytes
+		 * can still be added afterwards.
+		 */
+		auto digest() const -> std::uint64_t;
+
+	private:
+		static constexpr std::size_t stripe_size = 32;
+
+		auto consume_stripe(const char *stripe) -> void;
+
+		std::uint64_t seed;
+		std::uint64_t total = 0;
+		std::array<std::uint64_t, 4> lanes;
+		// Tail of the input that does not fill a whole stripe yet
+		std::array<char, stripe_size> pending{};
+		std::size_t pending_size = 0;
+	};
+
+	/**
+	 * One-shot content_hasher, the value std::hash gives a view with the same chars
+	 */
+	auto content_hash(std::string_view bytes) -> std::size_t;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_CONTENT_HASH_H
@@ -0,0 +1,41 @@
+#include "./content_hash.h"
+#include <catch2/catch.hpp>
+
+#include <string>
+
+TEST_CASE("Content hash") {
+	SECTION("Matches the XXH64 reference values") {
+		REQUIRE(fsv::content_hash("") == 0xEF46DB3751D8E999u);
+		REQUIRE(fsv::content_hash("a") == 0xD24EC4F1A98C6E5Bu);
+		REQUIRE(fsv::content_hash("abc") == 0x44BC2CF5AD770999u);
+	}
+
+	SECTION("Does not depend on how the input is split") {
+		auto text = std::string{};
+		for (auto i = 0; i < 200; ++i) {
+			text += static_cast<char>(i * 7);
+		}
+		const auto whole = fsv::content_hash(text);
+		for (std::size_t piece = 1; piece <= 40; ++piece) {
+			auto hasher = fsv::content_hasher{};
+			for (std::size_t at = 0; at < text.size(); at += piece) {
+				hasher.update(std::string_view(text).substr(at, piece));
+			}
+			REQUIRE(hasher.digest() == whole);
+		}
+	}
+
+	SECTION("Digest can be taken midway") {
+		auto hasher = fsv::content_hasher{};
+		hasher.update("hello ");
+		REQUIRE(hasher.digest() == fsv::content_hash("hello "));
+		hasher.update("world");
+		REQUIRE(hasher.digest() == fsv::content_hash("hello world"));
+	}
+
+	SECTION("Seed changes the value") {
+		auto hasher = fsv::content_hasher{1};
+		hasher.update("abc");
+		REQUIRE(hasher.digest() != fsv::content_hash("abc"));
+	}
+}
@@ -2,126 +2,49 @@
 #include "filtered_string_view.h"
 
 // Implement here
-// Member operator
-// Initialization for static member
-fsv::filter fsv::filtered_string_view::default_predicate = [](const char &) {
-    return true;
-};
-
-// Copy assignment
-fsv::filtered_string_view fsv::filtered_string_view::operator=(const filtered_string_view &other) {
-    if (this == &other) {
-        return *this;
-    }
-
-    pointer = other.pointer;
-    length = other.length;
-    str_predicate = other.str_predicate;
-
-    return *this;
-};
-
-// Move assignment
-fsv::filtered_string_view fsv::filtered_string_view::operator=(filtered_string_view &&other) noexcept {
-    if (this == &other) {
-        return *this;
-    }
-    pointer = std::move(other.pointer);
-    length = std::move(other.length);
-    str_predicate = std::move(other.str_predicate);
-    other.pointer = nullptr;
-    other.length = 0;
-    other.str_predicate = default_predicate;
-    return *this;
-};
-
-// Subscript
-auto fsv::filtered_string_view::operator[](int n) const -> const char &{
-    return at(n);
-}
-
-// String Type Conversion
-fsv::filtered_string_view::operator std::string() const {
-    std::string return_string = "";
-    if (pointer == nullptr) {
-        return return_string;
-    }
-    size_t idx = 0;
-    while (idx < strlen(pointer)) {
-        if (str_predicate(pointer[idx])) {
-            return_string.push_back(pointer[idx]);
-        }
-        ++idx;
-    }
-    return return_string;
-};
+// The type-erased instantiation every other translation unit links against
+template class fsv::basic_filtered_string_view<fsv::filter>;
 
 // Compose
+// The filters go through pred::all_of, so byte_set filters merge into one table, a
+// compose of byte-pure filters only is a single byte_set again, and filters that
+// came out of an earlier compose are spliced in flat rather than called through.
+// The window of fsv is kept, so composing a substr or split segment still only
+// scans its own bytes.
 auto fsv::compose(const fsv::filtered_string_view &fsv, const std::vector<fsv::filter> &filts) -> fsv::filtered_string_view {
     if (fsv.data() == nullptr) {
         return fsv;
     };
 
-    const auto ult_predicate = [filts](const char &c) {
-        for (const auto &filt : filts) {
-            if (not filt(c)) {
-                return false;
-            }
-        }
-        return true;
-    };
+    auto ult_predicate = fsv::pred::all_of(std::vector<fsv::pred::expr>(filts.begin(), filts.end()));
 
-    return fsv::filtered_string_view(fsv.data(), ult_predicate);
+    return fsv::filtered_string_view(fsv.data(), fsv.buffer_size(), ult_predicate.compile())
+        .window(fsv.window_begin(), fsv.window_end());
 };
 
 // Split
-void cut_and_add_segments(std::vector<size_t> filter_position, 
-                            std::size_t start, std::size_t end, 
-                            fsv::filtered_string_view fsv, 
-                            std::vector<fsv::filtered_string_view> &return_vector) {
-    auto segment_start_idx = filter_position[start];
-    auto segment_pass_end_idx = filter_position[end];
-    auto segment_predicate = [fsv, segment_start_idx, segment_pass_end_idx](const char &c) {
-        std::size_t char_postion = static_cast<std::size_t>(&c - fsv.data());
-        return char_postion >= segment_start_idx and 
-                char_postion < segment_pass_end_idx and
-                fsv.predicate()(c);
-    };
-    return_vector.emplace_back(fsv.data(), segment_predicate);
-}
+// Collects split_view, which finds the tokens with KMP over the passing chars: each
+// char is looked at once and each segment is a window of fsv over its own bytes only.
 auto fsv::split(const fsv::filtered_string_view &fsv, const fsv::filtered_string_view &tok) -> std::vector<fsv::filtered_string_view> {
     std::vector<fsv::filtered_string_view> return_vector;
-    if (tok.size() == 0) {
-        const fsv::filtered_string_view fsv_copy = fsv;
-        return_vector.push_back(fsv_copy);
-        return return_vector;
-    }
-    auto fsv_data = fsv.data();
-    auto fsv_str = static_cast<std::string>(fsv);
-    auto tok_str = static_cast<std::string>(tok);
-    auto tok_len = tok_str.size();
-    std::size_t start = 0;
-    std::size_t end = 0;
-    // Store the location of each valid character in fsv (passing through predicate)
-    std::vector<size_t> filter_position;
-    for (size_t i = 0; i < strlen(fsv_data); ++i) {
-        if (fsv.predicate()(fsv_data[i])) {
-            filter_position.push_back(i);
-        }
+    for (auto segment : fsv::split_view(fsv, tok)) {
+        return_vector.push_back(std::move(segment));
     }
+    return return_vector;
+};
 
-    // Splitting fsv into segments 
-    while ((end = fsv_str.find(tok_str, start)) != std::string::npos) {
-        cut_and_add_segments(filter_position, start, end, fsv, return_vector);
-        start = end + tok_len;
+auto fsv::split(const fsv::filtered_string_view &fsv, const fsv::byte_set &delimiters, fsv::split_mode mode)
+    -> std::vector<fsv::filtered_string_view> {
+    std::vector<fsv::filtered_string_view> return_vector;
+    for (auto segment : fsv::split_view(fsv, delimiters, mode)) {
+        return_vector.push_back(std::move(segment));
     }
-
-    // Adding the last segments
-    cut_and_add_segments(filter_position, start, strlen(fsv_data), fsv, return_vector);
     return return_vector;
 };
 
 // Substring
+// The window from the pos-th to the (pos + count - 1)-th passing char, found once:
+// by select when fsv has an index, otherwise in a single walk.
 auto fsv::substr(const fsv::filtered_string_view &fsv, int pos, int count) -> fsv::filtered_string_view {
     if (fsv.size() == 0) {
         auto return_fs = fsv::filtered_string_view("");
@@ -133,11 +56,19 @@ auto fsv::substr(const fsv::filtered_string_view &fsv, int pos, int count) -> fs
     } else {
         rcount = count;
     }
-    auto segment_predicate = [fsv, pos, rcount](const char &c) {
-        const char * char_ptr = fsv.data() +  (&c - fsv.data());
-        return char_ptr >= &fsv[pos] and 
-                char_ptr <= &fsv[pos + rcount - 1] and
-                fsv.predicate()(c);
-    };
-    return fsv::filtered_string_view{fsv.data(), segment_predicate};
+    if (pos < 0 or rcount <= 0 or static_cast<std::size_t>(pos) + static_cast<std::size_t>(rcount) > fsv.size()) {
+        throw std::domain_error{"fsv::substr(" + std::to_string(pos) + ", " + std::to_string(count) + "): invalid range"};
+    }
+
+    const char *first = nullptr;
+    const char *last = nullptr;
+    if (fsv.has_index()) {
+        first = &fsv[pos];
+        last = &fsv[pos + rcount - 1] + 1;
+    } else {
+        auto it = std::next(fsv.begin(), pos);
+        first = &*it;
+        last = &*std::next(it, rcount - 1) + 1;
+    }
+    return fsv.window(static_cast<std::size_t>(first - fsv.data()), static_cast<std::size_t>(last - fsv.data()));
 };
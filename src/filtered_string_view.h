@@ -1,18 +1,228 @@
 #ifndef COMP6771_ASS2_FSV_H
 #define COMP6771_ASS2_FSV_H
 
+#include <algorithm>
 #include <compare>
+#include <concepts>
 #include <functional>
 #include <iterator>
 #include <optional>
+#include <ranges>
+#include <variant>
+#include <vector>
 #include <string>
+#include <string_view>
 #include <iostream>
 #include <cstring>
+#include <memory>
+#include <type_traits>
+#include <typeinfo>
+
+#include "./byte_set.h"
+#include "./content_hash.h"
+#include "./position_index.h"
+#include "./predicate.h"
+#include "./two_way.h"
 namespace fsv {
-	using filter = std::function<bool(const char &)>;
-	class filtered_string_view {
+	template<typename Pred = filter>
+		requires std::predicate<const Pred &, const char &>
+	class basic_filtered_string_view;
+
+	/**
+	 * The type-erased view: any predicate fits behind the std::function, so this is
+	 * the form to store, pass across library boundaries and return from compose/split/substr.
+	 */
+	using filtered_string_view = basic_filtered_string_view<filter>;
+
+	template<typename Pred>
+		requires std::predicate<const Pred &, const char &>
+	class basic_split_view;
+
+	class multi_matcher;
+	class regex;
+
+	namespace detail {
+		template<typename Pred>
+		auto make_default_predicate() -> Pred {
+			if constexpr (std::is_same_v<Pred, filter>) {
+				// Seen as the full byte_set, so views know it needs no filtering
+				return pass_all{};
+			}
+			else {
+				return Pred{};
+			}
+		}
+
+		/**
+		 * The predicate of a view with a run_index: whether the byte lies in one of
+		 * the recorded runs. It looks at the address of the char, not its value.
+		 */
+		struct frozen_runs {
+			const run_index *runs;
+			// The byte the run offsets count from, i.e. the start of the view's window
+			const char *base;
+
+			auto operator()(const char &c) const -> bool {
+				return runs->contains(static_cast<std::size_t>(&c - base));
+			}
+		};
+
+		/**
+		 * Hands out the passing chars of [first, last) as a sequence of string_views,
+		 * so callers can memcmp, write or hash them in bulk without materialising the
+		 * whole filtered string. next() returns an empty view once the input is used up.
+		 *
+		 * The input is taken as runs of consecutive passing bytes. A run of at least
+		 * capacity bytes is handed out in place, uncopied; shorter runs are gathered
+		 * into the internal buffer, with byte_set::compact when the predicate is a
+		 * byte_set and one memcpy per run otherwise. The full byte_set is a single
+		 * run, and frozen_runs reads the recorded runs without testing any byte.
+		 * Otherwise each byte is tested once. The extra memory is the fixed internal
+		 * buffer, so a reader must not be copied or moved while a view it returned
+		 * is still in use.
+		 */
+		template<typename Pred>
+		class chunk_reader {
+		public:
+			static constexpr std::size_t capacity = 512;
+
+			chunk_reader(const char *first, const char *last, const Pred &pred)
+				: pos(first),
+				  run_last(first),
+				  last(last),
+				  pred(pred)
+			{
+
+			}
+
+			chunk_reader(const chunk_reader &) = delete;
+			auto operator=(const chunk_reader &) -> chunk_reader & = delete;
+
+			auto next() -> std::string_view {
+				if constexpr (std::is_same_v<Pred, byte_set>) {
+					if (pred.is_all()) {
+						auto rest = std::string_view(pos, static_cast<std::size_t>(last - pos));
+						pos = last;
+						return rest;
+					}
+					pos = pred.find_first(pos, last);
+					// Probe at most capacity bytes: only a run that long is worth handing out whole
+					const auto rejects = ~pred;
+					if (static_cast<std::size_t>(last - pos) >= capacity
+					    and rejects.find_first(pos, pos + capacity) == pos + capacity)
+					{
+						const auto run = std::string_view(pos, static_cast<std::size_t>(rejects.find_first(pos + capacity, last) - pos));
+						pos += run.size();
+						return run;
+					}
+					auto out = buffer;
+					while (out == buffer and pos != last) {
+						const auto window = std::min(capacity, static_cast<std::size_t>(last - pos));
+						out = pred.compact(pos, pos + window, buffer, buffer + capacity);
+						pos += window;
+					}
+					return std::string_view(buffer, static_cast<std::size_t>(out - buffer));
+				}
+				else {
+					std::size_t filled = 0;
+					while (filled != capacity) {
+						// [pos, run_last) is what is left of the run being read
+						if constexpr (std::is_same_v<Pred, frozen_runs>) {
+							if (pos == run_last) {
+								const auto k = pred.runs->run_after(static_cast<std::size_t>(pos - pred.base));
+								if (k == pred.runs->run_count()) {
+									pos = last;
+									run_last = last;
+									break;
+								}
+								const auto [start, length] = pred.runs->run(k);
+								pos = std::max(pos, pred.base + start);
+								run_last = std::min(pred.base + start + length, last);
+								if (pos >= last) {
+									pos = last;
+									run_last = last;
+									break;
+								}
+							}
+						}
+						else if (pos == run_last) {
+							if (rejected) {
+								++pos;
+							}
+							while (pos != last and not pred(*pos)) {
+								++pos;
+							}
+							run_last = pos == last ? pos : pos + 1;
+							while (run_last != last and pred(*run_last)) {
+								++run_last;
+							}
+							rejected = run_last != last;
+							if (pos == last) {
+								break;
+							}
+						}
+						const auto run = static_cast<std::size_t>(run_last - pos);
+						if (filled == 0 and run >= capacity) {
+							const auto whole = std::string_view(pos, run);
+							pos = run_last;
+							return whole;
+						}
+						const auto count = std::min(run, capacity - filled);
+						std::memcpy(buffer + filled, pos, count);
+						filled += count;
+						pos += count;
+					}
+					return std::string_view(buffer, filled);
+				}
+			}
+
+		private:
+			const char *pos;
+			// End of the run pos is in, for predicates that are tested per byte,
+			// and whether the byte there is already known to fail
+			const char *run_last;
+			bool rejected = false;
+			const char *last;
+			const Pred &pred;
+			char buffer[capacity];
+		};
+
+		template<typename LhsPred, typename RhsPred>
+		auto compare(const basic_filtered_string_view<LhsPred> &lhs, const basic_filtered_string_view<RhsPred> &rhs)
+		    -> std::strong_ordering;
+	} // namespace detail
+
+	/**
+	 * A filtered view whose predicate type is a template parameter, so lambdas and
+	 * function objects inline into size(), at(), iteration and materialisation
+	 * instead of costing an indirect std::function call per byte.
+	 *
+	 *   auto digits = fsv::basic_filtered_string_view{log_line, [](const char &c) { return std::isdigit(c); }};
+	 *
+	 * Converts implicitly to filtered_string_view, the type-erased form.
+	 */
+	template<typename Pred>
+		requires std::predicate<const Pred &, const char &>
+	class basic_filtered_string_view {
+		template<typename OtherPred>
+			requires std::predicate<const OtherPred &, const char &>
+		friend class basic_filtered_string_view;
+
+		template<typename LhsPred, typename RhsPred>
+		friend auto detail::compare(const basic_filtered_string_view<LhsPred> &lhs,
+		                            const basic_filtered_string_view<RhsPred> &rhs) -> std::strong_ordering;
+
+		friend struct std::hash<basic_filtered_string_view>;
+
+		template<typename SplitPred>
+			requires std::predicate<const SplitPred &, const char &>
+		friend class basic_split_view;
+
+		friend class multi_matcher;
+		friend class regex;
+
 		class iter {
-			friend filtered_string_view;
+			friend basic_filtered_string_view;
 
 		 public:
 			using iterator_category = std::bidirectional_iterator_tag;
@@ -24,68 +234,130 @@ namespace fsv {
 			iter() = default;
 
 			auto operator*() const -> reference {
-				return (*fsv_ptr).at(idx);
+				return *pos;
 			}; 
 
 			auto operator->() const -> pointer {
 				
 			};
 
+			/**
+			 * Moves straight to the next passing character in the underlying buffer,
+			 * so a full pass over the view calls the predicate once per byte.
+			 */
 			auto operator++() -> iter& {
-				++idx;
+				pos = fsv_ptr->next_passing(pos + 1);
             	return *this;
 			};
 
 			auto operator++(int) -> iter {
-				auto newIter = iter(fsv_ptr, idx + 1);
-				return newIter;
+				auto oldIter = *this;
+				++*this;
+				return oldIter;
 			};
 
 			auto operator--() -> iter& {
-				--idx;
+				pos = fsv_ptr->prev_passing(pos);
             	return *this;
 			};
 
 			auto operator--(int) -> iter {
-				auto newIter = iter(fsv_ptr, idx + 1);
-				return newIter;
+				auto oldIter = *this;
+				--*this;
+				return oldIter;
 			};
 
 			friend auto operator==(const iter& lhs, const iter& rhs) -> bool {
-				return lhs.idx == rhs.idx and lhs.fsv_ptr == rhs.fsv_ptr;
+				return lhs.pos == rhs.pos and lhs.fsv_ptr == rhs.fsv_ptr;
 			};
 
 			friend auto operator!=(const iter& lhs , const iter& rhs) -> bool {
-				return lhs.idx != rhs.idx or lhs.fsv_ptr != rhs.fsv_ptr;
+				return lhs.pos != rhs.pos or lhs.fsv_ptr != rhs.fsv_ptr;
 			};
 
 		 private:
 			/* Implementation-specific private members */
-			iter(const filtered_string_view *ptr, const int idx) : idx(idx), fsv_ptr(ptr) {}; 
-			int idx;
-			const filtered_string_view *fsv_ptr;
+			iter(const basic_filtered_string_view *ptr, const char *pos) : pos(pos), fsv_ptr(ptr) {}; 
+			// position in the underlying buffer: a passing char, or the end of the window
+			const char *pos = nullptr;
+			const basic_filtered_string_view *fsv_ptr = nullptr;
+		};
+
+		/**
+		 * Forward iterator over the runs of a view: the maximal spans of consecutive
+		 * passing bytes, as string_views into the underlying buffer.
+		 */
+		class run_iter {
+			friend basic_filtered_string_view;
+
+		public:
+			using iterator_concept = std::forward_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using value_type = std::string_view;
+			using difference_type = std::ptrdiff_t;
+
+			run_iter() = default;
+
+			auto operator*() const -> value_type {
+				return std::string_view(run_first, static_cast<std::size_t>(run_last - run_first));
+			}
+
+			auto operator++() -> run_iter & {
+				// The byte that ended the run failed the predicate already
+				*this = fsv_ptr->run_from(run_last == fsv_ptr->window_last ? run_last : run_last + 1);
+				return *this;
+			}
+
+			auto operator++(int) -> run_iter {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+
+			friend auto operator==(const run_iter &lhs, const run_iter &rhs) -> bool {
+				return lhs.run_first == rhs.run_first;
+			}
+
+			// Runs are never empty, so an empty one marks the end
+			friend auto operator==(const run_iter &it, std::default_sentinel_t) -> bool {
+				return it.run_first == it.run_last;
+			}
+
+		private:
+			run_iter(const basic_filtered_string_view *ptr, const char *first, const char *last)
+				: fsv_ptr(ptr),
+				  run_first(first),
+				  run_last(last)
+			{
+
+			}
+
+			const basic_filtered_string_view *fsv_ptr = nullptr;
+			const char *run_first = nullptr;
+			const char *run_last = nullptr;
 		};
 
 	public:
 		using const_iterator = iter;
 		using iterator = const_iterator;
+		using run_iterator = run_iter;
 		using reverse_iterator = std::reverse_iterator<iterator>;
 		using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
 		auto begin()-> iterator {
-			return { this, 0 };
+			return { this, next_passing(window_first) };
 		}
 
 		auto end()-> iterator {
-			return { this, static_cast<int>(size()) };
+			return { this, window_last };
 		}
 
 		auto begin() const -> const_iterator {
-			return { this, 0 };
+			return { this, next_passing(window_first) };
 		}
 
 		auto end() const -> const_iterator {
-			return { this, static_cast<int>(size()) };
+			return { this, window_last };
 		}
 
 		auto cbegin() const -> const_iterator {
@@ -121,22 +393,56 @@ namespace fsv {
 			return rend();
 		}
 
+		/**
+		 * The maximal runs of consecutive passing bytes, in order, as string_views into
+		 * the underlying buffer: nothing is copied. Concatenated they are the filtered
+		 * string. A byte_set finds run boundaries with its vector kernels. Like
+		 * begin(), the iterators refer to this view.
+		 *
+		 *   for (auto run : view.runs()) { out.write(run.data(), run.size()); }
+		 */
+		auto runs() const -> std::ranges::subrange<run_iterator, std::default_sentinel_t> {
+			return {run_from(window_first), std::default_sentinel};
+		}
+
+		/**
+		 * Calls f(std::string_view) on every run, as runs() lists them.
+		 * If f returns bool, returning false stops at that run.
+		 */
+		template<typename F>
+		auto for_each_run(F &&f) const -> void {
+			for (auto run = run_from(window_first); run != std::default_sentinel; ++run) {
+				if constexpr (std::is_same_v<std::invoke_result_t<F &, std::string_view>, bool>) {
+					if (not f(*run)) {
+						return;
+					}
+				}
+				else {
+					f(*run);
+				}
+			}
+		}
+
 		/**
 		 * Should this be public or not? 
 		 * There are systems which make this public
 		 * There are systems that don't
 		 * We do it here because we need to test it
+		 *
+		 * For filtered_string_view this is the true predicate, for any other
+		 * predicate type it is a value-initialised Pred.
 		*/ 
-		static filter default_predicate;
+		static inline Pred default_predicate = detail::make_default_predicate<Pred>();
 
 		/**
 		 * the pointer set to nullptr, 
 		 * the length set to 0, 
 		 * and the predicate set to the true predicate.
 		 */
-		filtered_string_view()
+		basic_filtered_string_view()
 			: pointer(nullptr),
-			length(0) 
+			length(0),
+			filtered_size(0)
 		{
 
 		};
@@ -148,7 +454,7 @@ namespace fsv {
 		 * Use c_str() for C compability, avoid writting on string, have null termination
 		 * Use data() will allow write over string + not guranteed "\o" -> not using it.
 		 */
-		filtered_string_view(const std::string &str)
+		basic_filtered_string_view(const std::string &str)
 			: pointer(str.c_str()), 
 			  length(str.size()) 
 		{
@@ -159,10 +465,10 @@ namespace fsv {
 		 * Same as the Implicit String Constructor, 
 		 * but with the predicate set to the given one.
 		 */
-		filtered_string_view(const std::string &str, filter predicate)
+		basic_filtered_string_view(const std::string &str, Pred predicate)
 			: pointer(str.c_str()), 
 			  length(str.size()),
-			  str_predicate(predicate)
+			  str_predicate(std::move(predicate))
 		{
 
 		};
@@ -177,7 +483,7 @@ namespace fsv {
 		 * 
 		 * You can assume that the passed in string pointer is validly null-terminated
 		 */
-		filtered_string_view(const char *str) 			
+		basic_filtered_string_view(const char *str) 			
 			: pointer(str), 
 			  length(std::strlen(str))
 		{
@@ -188,10 +494,50 @@ namespace fsv {
 		 * Same as the implicit null-terminated string pointer constructor, 
 		 * but with the predicate set to the given one.
 		 */
-		filtered_string_view(const char *str, filter predicate) 			
+		basic_filtered_string_view(const char *str, Pred predicate) 			
 			: pointer(str), 
 			  length(std::strlen(str)),
-			  str_predicate(predicate)
+			  str_predicate(std::move(predicate))
+		{
+
+		};
+
+		/**
+		 * the pointer and length set to the given view's, and the predicate set to the true predicate.
+		 *
+		 * The buffer does not need to be null-terminated and may contain '\0',
+		 * every operation is bounded by str.size().
+		 */
+		basic_filtered_string_view(std::string_view str)
+			: pointer(str.data()),
+			  length(str.size())
+		{
+
+		};
+
+		basic_filtered_string_view(std::string_view str, Pred predicate)
+			: pointer(str.data()),
+			  length(str.size()),
+			  str_predicate(std::move(predicate))
+		{
+
+		};
+
+		/**
+		 * View of the len bytes at str, e.g. a slice of an mmap'd or network buffer.
+		 * Same as the string_view constructors: no terminator needed, embedded '\0' allowed.
+		 */
+		basic_filtered_string_view(const char *str, std::size_t len)
+			: pointer(str),
+			  length(len)
+		{
+
+		};
+
+		basic_filtered_string_view(const char *str, std::size_t len, Pred predicate)
+			: pointer(str),
+			  length(len),
+			  str_predicate(std::move(predicate))
 		{
 
 		};
@@ -201,10 +547,14 @@ namespace fsv {
 		 * A member-wise copy is sufficient.
 		 * The underlying character buffer should not be deep-copied.
 		 */
-		filtered_string_view(const filtered_string_view &other)
+		basic_filtered_string_view(const basic_filtered_string_view &other)
 			: pointer(other.data()), 
-			  length(other.size()),
-			  str_predicate(other.predicate()) 
+			  length(other.length),
+			  window_first(other.window_first),
+			  window_last(other.window_last),
+			  str_predicate(other.str_predicate),
+			  filtered_size(other.filtered_size),
+			  str_index(other.str_index)
 		{
 
 		};
@@ -216,20 +566,49 @@ namespace fsv {
 		 * The moved from object should be in the same state 
 		 * as a default constructed fsv::filtered_string_view.
 		 */
-		filtered_string_view(filtered_string_view &&other)
+		basic_filtered_string_view(basic_filtered_string_view &&other)
 			: pointer(std::move(other.pointer)), 
 			  length(std::move(other.length)),
-			  str_predicate(std::move(other.str_predicate)) 
+			  window_first(other.window_first),
+			  window_last(other.window_last),
+			  str_predicate(std::move(other.str_predicate)),
+			  filtered_size(std::move(other.filtered_size)),
+			  str_index(std::move(other.str_index))
 		{
 			other.pointer = nullptr;
 			other.length = 0;
-			other.str_predicate = default_predicate;
+			other.window_first = nullptr;
+			other.window_last = nullptr;
+			if constexpr (resettable_predicate) {
+				other.str_predicate = default_predicate;
+			}
+			other.filtered_size = 0;
+			other.str_index.reset();
 		};
 
+		/**
+		 * Converts a view with another predicate type, typically a statically typed
+		 * one into the type-erased filtered_string_view. Shares the buffer, the
+		 * cached size and any index, since they only depend on which bytes pass.
+		 */
+		template<typename OtherPred>
+			requires(not std::is_same_v<OtherPred, Pred> and std::is_constructible_v<Pred, const OtherPred &>)
+		basic_filtered_string_view(const basic_filtered_string_view<OtherPred> &other)
+			: pointer(other.pointer),
+			  length(other.length),
+			  window_first(other.window_first),
+			  window_last(other.window_last),
+			  str_predicate(other.str_predicate),
+			  filtered_size(other.filtered_size),
+			  str_index(other.str_index)
+		{
+
+		}
+
 		/**
 		 * Important: You must explicitly declare the destructor as default.
 		 */
-		~filtered_string_view() = default;
+		~basic_filtered_string_view() = default;
 
 		/**
 		 * Copies at least the length, data and predicate of other 
@@ -238,7 +617,7 @@ namespace fsv {
 		 * 
 		 * In the case of self-copy, the object should remain unchanged.
 		 */
-		filtered_string_view operator=(const filtered_string_view &other);
+		auto operator=(const basic_filtered_string_view &other) -> basic_filtered_string_view &;
 
 		/**
 		 * The moved from object should be left in a valid state 
@@ -247,7 +626,7 @@ namespace fsv {
 		 * except in the case of self-assignment, 
 		 * in which the moved from object should remain unchanged.
 		 */
-		filtered_string_view operator=(filtered_string_view &&other) noexcept;
+		auto operator=(basic_filtered_string_view &&other) noexcept -> basic_filtered_string_view &;
 
 		/**
 		 * Allows reading a character from the filtered string given its index.
@@ -259,55 +638,104 @@ namespace fsv {
 		auto operator[](int n) const -> const char &;
 
 
-		friend auto operator==(const fsv::filtered_string_view &lhs, 
+		/**
+		 * Comparisons against filtered_string_view also take string literals,
+		 * std::string and std::string_view through its implicit constructors. Two views
+		 * with static predicates are compared directly, without type-erasing either side.
+		 */
+		friend auto operator==(const basic_filtered_string_view &lhs, 
 								const fsv::filtered_string_view &rhs) -> bool {
+			if (lhs.known_sizes_differ(rhs)) {
+				return false;
+			}
 			return (lhs <=> rhs) == std::strong_ordering::equal;
 		};
 
 
-		friend auto operator<=>(const filtered_string_view &lhs,
-								const filtered_string_view &rhs) -> std::strong_ordering {
-			auto lhs_string = static_cast<std::string>(lhs);
-			auto rhs_string = static_cast<std::string>(rhs);
-			return lhs_string <=> rhs_string;
+		friend auto operator<=>(const basic_filtered_string_view &lhs,
+								const fsv::filtered_string_view &rhs) -> std::strong_ordering {
+			return detail::compare(lhs, rhs);
 		};
 
-		friend auto operator<<(std::ostream &os, const filtered_string_view &fsv) -> std::ostream& {
-			auto fsv_string = static_cast<std::string>(fsv);
-			return os << fsv_string;
+		template<typename OtherPred>
+		friend auto operator==(const basic_filtered_string_view &lhs,
+		                       const basic_filtered_string_view<OtherPred> &rhs) -> bool {
+			if (lhs.known_sizes_differ(rhs)) {
+				return false;
+			}
+			return detail::compare(lhs, rhs) == std::strong_ordering::equal;
+		}
+
+		template<typename OtherPred>
+		friend auto operator<=>(const basic_filtered_string_view &lhs,
+		                        const basic_filtered_string_view<OtherPred> &rhs) -> std::strong_ordering {
+			return detail::compare(lhs, rhs);
+		}
+
+		/**
+		 * Writes the passing chars straight into the stream buffer, a chunk at a time,
+		 * with the same width/fill padding as inserting the materialised std::string.
+		 * Uses a fixed amount of extra memory however long the view is.
+		 */
+		friend auto operator<<(std::ostream &os, const basic_filtered_string_view &fsv) -> std::ostream& {
+			const auto sentry = std::ostream::sentry(os);
+			if (not sentry) {
+				return os;
+			}
+			auto failed = false;
+			const auto pad = [&](std::streamsize count) {
+				for (; count > 0 and not failed; --count) {
+					failed = std::ostream::traits_type::eq_int_type(os.rdbuf()->sputc(os.fill()),
+					                                                std::ostream::traits_type::eof());
+				}
+			};
+			const auto width = os.width();
+			const auto padding = width > 0 ? width - static_cast<std::streamsize>(fsv.size()) : 0;
+			const auto left = (os.flags() & std::ios_base::adjustfield) == std::ios_base::left;
+			if (not left) {
+				pad(padding);
+			}
+			fsv.with_predicate([&](const auto &pred) {
+				auto chunks = detail::chunk_reader{fsv.window_first, fsv.window_last, pred};
+				for (auto chunk = chunks.next(); not chunk.empty() and not failed; chunk = chunks.next()) {
+					const auto count = static_cast<std::streamsize>(chunk.size());
+					failed = os.rdbuf()->sputn(chunk.data(), count) != count;
+				}
+			});
+			if (left) {
+				pad(padding);
+			}
+			os.width(0);
+			if (failed) {
+				os.setstate(std::ios_base::badbit);
+			}
+			return os;
 		}
 
 		// Member functions
 		/**
 		 * Returns the size of the filtered string
+		 *
+		 * The first call scans the window once, the result is memoized in filtered_size
+		 * so every later call (and end(), empty(), at()) is O(1).
 		 */
 		auto size() const -> std::size_t { 
-			if (pointer == nullptr) {
-				return 0;
-			}
-			size_t sv_len = 0;
-			const char *temp_pointer = pointer;
-			while (*temp_pointer != '\0') {
-				if (str_predicate(*temp_pointer)) {
-					sv_len++;
-				}
-				temp_pointer++;
+			if (filtered_size) {
+				return *filtered_size;
 			}
+			auto sv_len = count_passing(window_first, window_last);
+			filtered_size = sv_len;
 			return sv_len; 
 		}
 
 		auto at(int index) const -> const char & {
 			if (0 <= index && static_cast<size_t>(index) < size()) {
-				auto temp_ptr = pointer;
-				auto idx = 0;
-				while (*temp_ptr != '\0') {
-					if (str_predicate(*temp_ptr)) {
-						if (idx == index) {
-							break;
-						}
-						++idx;
-					}
-					++temp_ptr;
+				if (str_index) {
+					return window_first[indexed_select(static_cast<std::size_t>(index))];
+				}
+				auto temp_ptr = next_passing(window_first);
+				for (auto idx = 0; idx < index; ++idx) {
+					temp_ptr = next_passing(temp_ptr + 1);
 				}
 				return *temp_ptr;
 			} else {
@@ -315,8 +743,107 @@ namespace fsv {
 			}
 		}
 		
+		/**
+		 * O(1) once size() is known, otherwise stops at the first passing char
+		 * rather than counting them all.
+		 */
 		auto empty() const -> bool {
-			return size() == 0;
+			if (filtered_size) {
+				return *filtered_size == 0;
+			}
+			return next_passing(window_first) == window_last;
+		}
+
+		/**
+		 * Number of filtered characters in the first offset bytes of data(),
+		 * i.e. the index in this view of the first passing char at or after data() + offset.
+		 *
+		 * O(1) with a rank/select index, a scan from the nearest checkpoint with a
+		 * sampled index, otherwise a scan of offset bytes.
+		 */
+		auto rank(std::size_t offset) const -> std::size_t {
+			const auto position = pointer + std::min(offset, length);
+			if (position <= window_first) {
+				return 0;
+			}
+			const auto window_offset = static_cast<std::size_t>(std::min(position, window_last) - window_first);
+			if (str_index) {
+				return indexed_rank(window_offset);
+			}
+			return count_passing(window_first, window_first + window_offset);
+		}
+
+		/**
+		 * Opt-in succinct index: one bit per byte plus per-block popcount prefix sums
+		 * (about length / 8 * 1.15 bytes). Afterwards at() and operator[] are a select
+		 * and rank() is a rank instead of linear scans.
+		 *
+		 * The index is shared between copies of this view and is dropped on move.
+		 * Build it once on a view that is probed many times.
+		 */
+		auto build_rank_select_index() -> void {
+			auto index = with_predicate([this](const auto &pred) {
+				return detail::rank_select_index(window_first, window_size(), pred);
+			});
+			filtered_size = index.size();
+			str_index = std::make_shared<const detail::position_index>(std::move(index));
+		}
+
+		/**
+		 * Opt-in memory-bounded index: the byte offset of every stride-th passing char,
+		 * i.e. size() / stride offsets. at() and operator[] jump to the checkpoint
+		 * index / stride and walk over fewer than stride passing chars from there.
+		 *
+		 * Replaces any index already built. Shared between copies, dropped on move.
+		 */
+		auto build_sampled_index(std::size_t stride) -> void {
+			if (stride == 0) {
+				throw std::domain_error{"filtered_string_view::build_sampled_index(0): stride must be positive"};
+			}
+			auto index = with_predicate([this, stride](const auto &pred) {
+				return detail::sampled_index(window_first, window_size(), pred, stride);
+			});
+			filtered_size = index.size();
+			str_index = std::make_shared<const detail::position_index>(std::move(index));
+		}
+
+		/**
+		 * Opt-in "freeze" for views traversed many times: records the run list, i.e.
+		 * the (offset, length) of every run of passing chars, in one scan. Memory is
+		 * two offsets per run.
+		 *
+		 * Afterwards size() is O(1), at(), operator[] and rank() are binary searches
+		 * over the runs' prefix sums, and iteration, runs(), materialisation, output,
+		 * hashing, comparison and searching read the runs instead of calling the
+		 * predicate. byte_set predicates keep their vector kernels, which need no
+		 * calls either, and only gain the O(log runs) at() and rank().
+		 *
+		 * Replaces any index already built. Shared between copies, dropped on move.
+		 */
+		auto build_run_index() -> void {
+			auto index = with_predicate([this](const auto &pred) {
+				return detail::run_index(window_first, window_size(), pred);
+			});
+			filtered_size = index.size();
+			str_index = std::make_shared<const detail::position_index>(std::move(index));
+		}
+
+		auto drop_index() -> void {
+			str_index.reset();
+		}
+
+		auto has_index() const -> bool {
+			return str_index != nullptr;
+		}
+
+		/**
+		 * Bytes held by the index of this view (0 without one).
+		 */
+		auto index_memory_usage() const -> std::size_t {
+			if (not str_index) {
+				return 0;
+			}
+			return std::visit([](const auto &index) { return index.memory_usage(); }, *str_index);
 		}
 		
 		/**
@@ -331,19 +858,915 @@ namespace fsv {
 		 */
 		explicit operator std::string() const;
 
-		filter predicate() const { return str_predicate; };
+		Pred predicate() const { return str_predicate; };
 		const char* data() const { return pointer; }
+
+		/**
+		 * Number of bytes of the underlying buffer, before filtering
+		 */
+		auto buffer_size() const -> std::size_t { return length; }
+
+		/**
+		 * The same buffer and predicate, covering only the bytes [data() + begin, data() + end)
+		 * that are also in this view's window. substr and split return views made this
+		 * way, so they only ever scan their own bytes, however large the buffer is.
+		 * The cached size and any index are not carried over.
+		 */
+		auto window(std::size_t begin, std::size_t end) const -> basic_filtered_string_view {
+			auto view = basic_filtered_string_view(pointer, length, str_predicate);
+			view.window_first = std::clamp(pointer + std::min(begin, length), window_first, window_last);
+			view.window_last = std::clamp(pointer + std::min(end, length), view.window_first, window_last);
+			return view;
+		}
+
+		/**
+		 * Offset from data() of the first byte the view covers, 0 unless it is a window
+		 */
+		auto window_begin() const -> std::size_t {
+			return static_cast<std::size_t>(window_first - pointer);
+		}
+
+		/**
+		 * Offset from data() one past the last byte the view covers, buffer_size() unless it is a window
+		 */
+		auto window_end() const -> std::size_t {
+			return static_cast<std::size_t>(window_last - pointer);
+		}
+
+		// Searching the filtered string. Offsets are filtered offsets, as for operator[].
+
+		static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+		/**
+		 * Offset of the first occurrence of needle that starts at or after pos, or npos.
+		 *
+		 * Two-Way search (linear time, constant extra memory). An unfiltered view is
+		 * searched in place, skipping to candidates with memchr; any other view is
+		 * compacted a chunk at a time into a buffer of O(needle.size()) bytes.
+		 * Stops at the first match.
+		 */
+		auto find(std::string_view needle, std::size_t pos = 0) const -> std::size_t {
+			return search(needle, pos);
+		}
+
+		/**
+		 * Offset of the last occurrence of needle that starts at or before pos, or npos.
+		 *
+		 * Two-Way search over the needle and the filtered chars read backwards from
+		 * pos + needle.size(), so it stops at the last match. Needs size(), and for a
+		 * pos short of the end, the position of that filtered offset.
+		 */
+		auto rfind(std::string_view needle, std::size_t pos = npos) const -> std::size_t {
+			return reverse_search(needle, pos);
+		}
+
+		auto contains(std::string_view needle) const -> bool {
+			return find(needle) != npos;
+		}
+
+		/**
+		 * Only reads as far as the first mismatch, at most prefix.size() passing chars
+		 */
+		auto starts_with(std::string_view prefix) const -> bool {
+			if (auto set = byte_class(); set and set->is_all()) {
+				return std::string_view(window_first, window_size()).starts_with(prefix);
+			}
+			auto position = window_first;
+			for (auto c : prefix) {
+				position = next_passing(position);
+				if (position == window_last or *position != c) {
+					return false;
+				}
+				++position;
+			}
+			return true;
+		}
+
+		/**
+		 * Walks backwards from the end of the window, at most suffix.size() passing chars
+		 */
+		auto ends_with(std::string_view suffix) const -> bool {
+			if (auto set = byte_class(); set and set->is_all()) {
+				return std::string_view(window_first, window_size()).ends_with(suffix);
+			}
+			auto position = window_last;
+			for (auto c = suffix.rbegin(); c != suffix.rend(); ++c) {
+				position = last_passing_before(position);
+				if (position == nullptr or *position != *c) {
+					return false;
+				}
+			}
+			return true;
+		}
 		
 	private:
+		// Whether a moved-from view can get its predicate back to default_predicate
+		static constexpr bool resettable_predicate =
+		    std::is_default_constructible_v<Pred> and std::is_copy_assignable_v<Pred>;
+
+		auto window_size() const -> std::size_t {
+			return static_cast<std::size_t>(window_last - window_first);
+		}
+
+		/**
+		 * True when both sizes are already memoized and differ, so == can answer
+		 * without looking at a single char.
+		 */
+		template<typename OtherPred>
+		auto known_sizes_differ(const basic_filtered_string_view<OtherPred> &other) const -> bool {
+			return filtered_size and other.filtered_size and *filtered_size != *other.filtered_size;
+		}
+
+		/**
+		 * The predicate as a byte table when it is one, either statically or inside
+		 * the std::function of the type-erased view, otherwise nullptr.
+		 */
+		auto byte_class() const -> const byte_set * {
+			if constexpr (std::is_same_v<Pred, byte_set>) {
+				return &str_predicate;
+			}
+			else if constexpr (std::is_same_v<Pred, filter>) {
+				// Dispatched on target_type(): GCC 12 at -O3 otherwise reports target()'s
+				// own result as maybe-uninitialized once it is inlined into the iterators
+				const auto &type = str_predicate.target_type();
+				if (type == typeid(detail::pass_all)) {
+					return &detail::full_byte_set;
+				}
+				if (type == typeid(byte_set)) {
+					return str_predicate.template target<byte_set>();
+				}
+				return nullptr;
+			}
+			else {
+				return nullptr;
+			}
+		}
+
+		/**
+		 * Calls f with the predicate in its fastest known form: the byte_set when
+		 * byte_class() finds one, so per-byte tests inline to a table lookup, the
+		 * recorded runs of a run_index, otherwise the predicate itself.
+		 */
+		template<typename F>
+		auto with_predicate(F &&f) const -> decltype(auto) {
+			if (auto set = byte_class()) {
+				return f(*set);
+			}
+			if (auto runs = frozen()) {
+				return f(detail::frozen_runs{runs, window_first});
+			}
+			return f(str_predicate);
+		}
+
+		/**
+		 * The run_index of this view, nullptr without one
+		 */
+		auto frozen() const -> const detail::run_index * {
+			return std::get_if<detail::run_index>(str_index.get());
+		}
+
+		auto offset_of(const char *position) const -> std::size_t {
+			return static_cast<std::size_t>(position - window_first);
+		}
+
+		/**
+		 * Whether the char at position passes, from the run list when there is one
+		 */
+		auto passes(const char *position) const -> bool {
+			if (auto runs = frozen()) {
+				return runs->contains(offset_of(position));
+			}
+			return str_predicate(*position);
+		}
+
+		/**
+		 * First position in [from, window_last) whose char passes the predicate,
+		 * or window_last if there is none.
+		 */
+		auto next_passing(const char *from) const -> const char * {
+			const auto last = window_last;
+			if (auto set = byte_class()) {
+				return set->find_first(from, last);
+			}
+			if (auto runs = frozen()) {
+				const auto k = runs->run_after(offset_of(from));
+				return k == runs->run_count() ? last : std::max(from, window_first + runs->run(k).first);
+			}
+			while (from != last and not str_predicate(*from)) {
+				++from;
+			}
+			return from;
+		}
+
+		/**
+		 * The first run at or after from, or an empty one at window_last
+		 */
+		auto run_from(const char *from) const -> run_iter {
+			const auto first = next_passing(from);
+			auto last = first;
+			if (auto set = byte_class()) {
+				last = set->is_all() ? window_last : (~*set).find_first(first, window_last);
+			}
+			else if (auto runs = frozen(); runs and first != window_last) {
+				const auto [start, length] = runs->run(runs->run_after(offset_of(first)));
+				last = window_first + start + length;
+			}
+			else if (first != window_last) {
+				++last;
+				while (last != window_last and str_predicate(*last)) {
+					++last;
+				}
+			}
+			return run_iter(this, first, last);
+		}
+
+		auto count_passing(const char *first, const char *last) const -> std::size_t {
+			if (auto set = byte_class()) {
+				return set->count(first, last);
+			}
+			if (auto runs = frozen()) {
+				return runs->rank(offset_of(last)) - runs->rank(offset_of(first));
+			}
+			std::size_t passing = 0;
+			for (; first != last; ++first) {
+				if (str_predicate(*first)) {
+					++passing;
+				}
+			}
+			return passing;
+		}
+
+		/**
+		 * Byte offset of the index-th passing char through str_index.
+		 * Precondition: str_index is set and index < size()
+		 */
+		auto indexed_select(std::size_t index) const -> std::size_t {
+			if (auto rank_select = std::get_if<detail::rank_select_index>(str_index.get())) {
+				return rank_select->select(index);
+			}
+			if (auto runs = frozen()) {
+				return runs->select(index);
+			}
+			const auto &sampled = std::get<detail::sampled_index>(*str_index);
+			auto position = window_first + sampled.checkpoint_for_index(index);
+			for (auto skip = index % sampled.stride(); skip > 0; --skip) {
+				position = next_passing(position + 1);
+			}
+			return static_cast<std::size_t>(position - window_first);
+		}
+
+		auto indexed_rank(std::size_t offset) const -> std::size_t {
+			if (auto rank_select = std::get_if<detail::rank_select_index>(str_index.get())) {
+				return rank_select->rank(offset);
+			}
+			if (auto runs = frozen()) {
+				return runs->rank(offset);
+			}
+			const auto [before, from] = std::get<detail::sampled_index>(*str_index).checkpoint_before_offset(offset);
+			return before + count_passing(window_first + from, window_first + offset);
+		}
+
+		/**
+		 * Last position in [window_first, from) whose char passes the predicate.
+		 * Precondition: such a position exists (i.e. the iterator is not begin()).
+		 */
+		auto prev_passing(const char *from) const -> const char * {
+			if (auto set = byte_class()) {
+				return set->find_last(window_first, from);
+			}
+			if (auto runs = frozen()) {
+				return window_first + runs->select(runs->rank(offset_of(from)) - 1);
+			}
+			do {
+				--from;
+			} while (from != window_first and not str_predicate(*from));
+			return from;
+		}
+
+		/**
+		 * Like prev_passing, but returns nullptr when no char of [window_first, from) passes.
+		 */
+		auto last_passing_before(const char *from) const -> const char * {
+			if (auto set = byte_class()) {
+				const auto found = set->find_last(window_first, from);
+				return found == from ? nullptr : found;
+			}
+			if (auto runs = frozen()) {
+				const auto before = runs->rank(offset_of(from));
+				return before == 0 ? nullptr : window_first + runs->select(before - 1);
+			}
+			while (from != window_first) {
+				if (str_predicate(*--from)) {
+					return from;
+				}
+			}
+			return nullptr;
+		}
+
+		/**
+		 * Position of the passing char at filtered offset count, window_last when
+		 * count == size(), nullptr when count > size().
+		 */
+		auto skip_passing(std::size_t count) const -> const char * {
+			if (count == 0) {
+				return window_first;
+			}
+			if (auto set = byte_class(); set and set->is_all()) {
+				return count <= window_size() ? window_first + count : nullptr;
+			}
+			if (str_index) {
+				if (count >= size()) {
+					return count == size() ? window_last : nullptr;
+				}
+				return window_first + indexed_select(count);
+			}
+			auto position = next_passing(window_first);
+			for (; count > 0 and position != window_last; --count) {
+				position = next_passing(position + 1);
+			}
+			return count == 0 ? position : nullptr;
+		}
+
+		/**
+		 * First match of needle starting at filtered offset pos or later, or npos
+		 */
+		auto search(std::string_view needle, std::size_t pos) const -> std::size_t {
+			const auto start = skip_passing(pos);
+			if (start == nullptr) {
+				return npos;
+			}
+			if (needle.empty()) {
+				return pos;
+			}
+
+			const auto searcher = detail::two_way(needle);
+			if (auto set = byte_class(); set and set->is_all()) {
+				const auto hit = searcher.find(start, window_last);
+				return hit == window_last ? npos : pos + static_cast<std::size_t>(hit - start);
+			}
+
+			// Filtered chars are gathered into buffer; the last needle.size() - 1 of
+			// them are carried over to the next round, as a match may start there.
+			const auto carry = needle.size() - 1;
+			const auto capacity = carry + std::max(needle.size(), std::size_t{512});
+			char local[2048];
+			auto heap = std::vector<char>{};
+			auto buffer = local;
+			if (capacity > sizeof local) {
+				heap.resize(capacity);
+				buffer = heap.data();
+			}
+			auto result = npos;
+			with_predicate([&](const auto &pred) {
+				auto chunks = detail::chunk_reader{start, window_last, pred};
+				auto chunk = chunks.next();
+				auto base = pos;
+				std::size_t held = 0;
+				while (true) {
+					while (held < capacity and not chunk.empty()) {
+						const auto count = std::min(capacity - held, chunk.size());
+						std::memcpy(buffer + held, chunk.data(), count);
+						held += count;
+						chunk.remove_prefix(count);
+						if (chunk.empty()) {
+							chunk = chunks.next();
+						}
+					}
+					const auto last = buffer + held;
+					if (const auto hit = searcher.find(buffer, last); hit != last) {
+						result = base + static_cast<std::size_t>(hit - buffer);
+						return;
+					}
+					if (chunk.empty()) {
+						return;
+					}
+					std::memmove(buffer, last - carry, carry);
+					base += held - carry;
+					held = carry;
+				}
+			});
+			return result;
+		}
+
+		/**
+		 * Last match of needle starting at filtered offset pos or earlier, or npos.
+		 * Searches backwards from the end of the last candidate, so it stops at the
+		 * match closest to pos.
+		 */
+		auto reverse_search(std::string_view needle, std::size_t pos) const -> std::size_t {
+			const auto total = size();
+			if (needle.size() > total) {
+				return npos;
+			}
+			// Filtered offset one past the last char a match can cover
+			const auto end = std::min(pos, total - needle.size()) + needle.size();
+			if (needle.empty()) {
+				return end;
+			}
+
+			const auto searcher = detail::two_way(needle);
+			if (auto set = byte_class(); set and set->is_all()) {
+				const auto last = window_first + end;
+				const auto hit = searcher.rfind(window_first, last);
+				return hit == last ? npos : static_cast<std::size_t>(hit - window_first);
+			}
+
+			// The bytes before stop are read a block at a time from the back. The
+			// filtered chars of each block are gathered into scratch, then moved to the
+			// front of buffer ahead of the first needle.size() - 1 chars of the block
+			// after it, as a match may run into those.
+			const auto stop = end == total ? window_last : skip_passing(end);
+			const auto carry = needle.size() - 1;
+			const auto block = std::max(needle.size(), std::size_t{512});
+			char local[2048];
+			auto heap = std::vector<char>{};
+			auto buffer = local;
+			if (carry + 2 * block > sizeof local) {
+				heap.resize(carry + 2 * block);
+				buffer = heap.data();
+			}
+			const auto scratch = buffer + carry + block;
+			auto result = npos;
+			with_predicate([&](const auto &pred) {
+				auto hi = stop;
+				// Filtered offset of buffer[0]
+				auto base = end;
+				std::size_t held = 0;
+				while (hi != window_first) {
+					const auto lo = hi - std::min(block, static_cast<std::size_t>(hi - window_first));
+					auto chunks = detail::chunk_reader{lo, hi, pred};
+					std::size_t gathered = 0;
+					for (auto chunk = chunks.next(); not chunk.empty(); chunk = chunks.next()) {
+						std::memcpy(scratch + gathered, chunk.data(), chunk.size());
+						gathered += chunk.size();
+					}
+					hi = lo;
+					if (gathered == 0) {
+						continue;
+					}
+					const auto kept = std::min(held, carry);
+					std::memmove(buffer + gathered, buffer, kept);
+					std::memcpy(buffer, scratch, gathered);
+					held = gathered + kept;
+					base -= gathered;
+					const auto last = buffer + held;
+					if (const auto hit = searcher.rfind(buffer, last); hit != last) {
+						result = base + static_cast<std::size_t>(hit - buffer);
+						return;
+					}
+				}
+			});
+			return result;
+		}
+
 		const char* pointer; // raw pointer to the first char of the string
 		std::size_t length;
-		filter str_predicate = default_predicate;
+
+		// The bytes [window_first, window_last) of the buffer the view covers: every
+		// scan, count and index stays inside them. The whole buffer unless the view
+		// was made by window(), i.e. by substr or split.
+		const char *window_first = pointer;
+		const char *window_last = pointer + length;
+		Pred str_predicate = default_predicate;
+
+		/**
+		 * Lazily computed result of size(), carried through copies and moves.
+		 * The view never mutates the buffer, so it is only stale if the owner of the
+		 * buffer rewrites it behind the view's back, just like std::string_view.
+		 * Not synchronised: concurrent first calls to size() on one object must be
+		 * serialised by the caller.
+		 */
+		mutable std::optional<std::size_t> filtered_size;
+
+		// Optional random access index, see build_rank_select_index() and build_sampled_index()
+		std::shared_ptr<const detail::position_index> str_index;
+	};
+
+	// Copy assignment
+	template<typename Pred>
+		requires std::predicate<const Pred &, const char &>
+	auto basic_filtered_string_view<Pred>::operator=(const basic_filtered_string_view &other)
+	    -> basic_filtered_string_view & {
+		if (this == &other) {
+			return *this;
+		}
+
+		pointer = other.pointer;
+		length = other.length;
+		window_first = other.window_first;
+		window_last = other.window_last;
+		str_predicate = other.str_predicate;
+		filtered_size = other.filtered_size;
+		str_index = other.str_index;
+
+		return *this;
+	};
+
+	// Move assignment
+	template<typename Pred>
+		requires std::predicate<const Pred &, const char &>
+	auto basic_filtered_string_view<Pred>::operator=(basic_filtered_string_view &&other) noexcept
+	    -> basic_filtered_string_view & {
+		if (this == &other) {
+			return *this;
+		}
+		pointer = std::move(other.pointer);
+		length = std::move(other.length);
+		window_first = other.window_first;
+		window_last = other.window_last;
+		str_predicate = std::move(other.str_predicate);
+		filtered_size = std::move(other.filtered_size);
+		str_index = std::move(other.str_index);
+		other.pointer = nullptr;
+		other.length = 0;
+		other.window_first = nullptr;
+		other.window_last = nullptr;
+		if constexpr (resettable_predicate) {
+			other.str_predicate = default_predicate;
+		}
+		other.filtered_size = 0;
+		other.str_index.reset();
+		return *this;
+	};
+
+	// Subscript
+	template<typename Pred>
+		requires std::predicate<const Pred &, const char &>
+	auto basic_filtered_string_view<Pred>::operator[](int n) const -> const char & {
+		return at(n);
+	}
+
+	// String Type Conversion
+	// byte_set predicates count then left-pack into an exactly sized string,
+	// anything else appends its runs, one memcpy each.
+	template<typename Pred>
+		requires std::predicate<const Pred &, const char &>
+	basic_filtered_string_view<Pred>::operator std::string() const {
+		std::string return_string = "";
+		if (pointer == nullptr) {
+			return return_string;
+		}
+		if (auto set = byte_class()) {
+			if (set->is_all()) {
+				return_string.assign(window_first, window_size());
+				return return_string;
+			}
+			return_string.resize(size());
+			auto out = return_string.data();
+			set->compact(window_first, window_last, out, out + return_string.size());
+			return return_string;
+		}
+		if (filtered_size) {
+			return_string.reserve(*filtered_size);
+		}
+		for_each_run([&return_string](std::string_view run) { return_string.append(run); });
+		return return_string;
+	};
+
+	template<typename LhsPred, typename RhsPred>
+	auto detail::compare(const basic_filtered_string_view<LhsPred> &lhs, const basic_filtered_string_view<RhsPred> &rhs)
+	    -> std::strong_ordering {
+		// Same bytes through the same table: nothing to compare
+		if (lhs.window_first == rhs.window_first and lhs.window_last == rhs.window_last) {
+			auto lhs_set = lhs.byte_class();
+			auto rhs_set = rhs.byte_class();
+			if (lhs_set and rhs_set and *lhs_set == *rhs_set) {
+				return std::strong_ordering::equal;
+			}
+		}
+
+		// Walks both sides a chunk at a time. Identity predicates hand out their
+		// whole buffer, so two plain strings come down to a single memcmp.
+		// Chars compare as unsigned bytes, like std::string.
+		return lhs.with_predicate([&](const auto &lhs_pred) {
+			return rhs.with_predicate([&](const auto &rhs_pred) {
+				auto lhs_chunks = chunk_reader{lhs.window_first, lhs.window_last, lhs_pred};
+				auto rhs_chunks = chunk_reader{rhs.window_first, rhs.window_last, rhs_pred};
+				auto lhs_chunk = lhs_chunks.next();
+				auto rhs_chunk = rhs_chunks.next();
+				while (not lhs_chunk.empty() and not rhs_chunk.empty()) {
+					const auto common = std::min(lhs_chunk.size(), rhs_chunk.size());
+					if (auto order = std::memcmp(lhs_chunk.data(), rhs_chunk.data(), common); order != 0) {
+						return order <=> 0;
+					}
+					lhs_chunk.remove_prefix(common);
+					rhs_chunk.remove_prefix(common);
+					if (lhs_chunk.empty()) {
+						lhs_chunk = lhs_chunks.next();
+					}
+					if (rhs_chunk.empty()) {
+						rhs_chunk = rhs_chunks.next();
+					}
+				}
+				return not lhs_chunk.empty() <=> not rhs_chunk.empty();
+			});
+		});
+	}
+
+	// The type-erased form is compiled once, in filtered_string_view.cpp
+	extern template class basic_filtered_string_view<filter>;
+
+	/**
+	 * What splitting on a byte_set does with consecutive delimiters
+	 */
+	enum class split_mode {
+		// Every delimiter ends a segment, so "a,,b" gives "a", "", "b"
+		keep_empty,
+		// Runs of delimiters act as one and empty segments are dropped, so ",a,,b," gives "a", "b"
+		collapse,
+	};
+
+	/**
+	 * Lazy split: a forward range over the segments of source between non-overlapping
+	 * occurrences of token, leftmost first, like split(). Each increment looks for the
+	 * next token only, so stopping after the first few fields never touches the rest
+	 * of the buffer, and iterating allocates nothing. The segments are windows of
+	 * source, computed when dereferenced.
+	 *
+	 *   for (auto field : fsv::split_view{line, ","}) {
+	 *       if (field == "stop") break;
+	 *   }
+	 *
+	 * The token is matched with KMP over the passing chars; its chars and table are
+	 * copied once, when the split_view is made.
+	 *
+	 * Given a byte_set instead, any passing char in the set is a delimiter:
+	 *
+	 *   auto words = fsv::split_view{line, fsv::pred::space, fsv::split_mode::collapse};
+	 *
+	 * Delimiters are then found with byte_set::find_first, the SIMD classification
+	 * kernel. When the source predicate is itself a byte_set both tables are merged,
+	 * so the scan is a single pass at close to memchr speed.
+	 */
+	template<typename Pred>
+		requires std::predicate<const Pred &, const char &>
+	class basic_split_view : public std::ranges::view_interface<basic_split_view<Pred>> {
+	public:
+		class iterator {
+			friend basic_split_view;
+
+		public:
+			using iterator_concept = std::forward_iterator_tag;
+			using iterator_category = std::input_iterator_tag;
+			using value_type = basic_filtered_string_view<Pred>;
+			using difference_type = std::ptrdiff_t;
+
+			iterator() = default;
+
+			auto operator*() const -> value_type {
+				const auto base = parent->source.data();
+				return parent->source.window(static_cast<std::size_t>(segment_first - base),
+				                             static_cast<std::size_t>(segment_last - base));
+			}
+
+			auto operator++() -> iterator & {
+				if (not has_next) {
+					done = true;
+					return *this;
+				}
+				*this = parent->segment_from(next_first);
+				return *this;
+			}
+
+			auto operator++(int) -> iterator {
+				auto old = *this;
+				++*this;
+				return old;
+			}
+
+			friend auto operator==(const iterator &lhs, const iterator &rhs) -> bool {
+				return lhs.done == rhs.done and (lhs.done or lhs.segment_first == rhs.segment_first);
+			}
+
+			friend auto operator==(const iterator &it, std::default_sentinel_t) -> bool {
+				return it.done;
+			}
+
+		private:
+			const basic_split_view *parent = nullptr;
+			// The current segment, and where the one after it starts if there is one
+			const char *segment_first = nullptr;
+			const char *segment_last = nullptr;
+			const char *next_first = nullptr;
+			bool has_next = false;
+			bool done = true;
+		};
+
+		basic_split_view() = default;
+
+		basic_split_view(basic_filtered_string_view<Pred> source, byte_set delimiters,
+		                 split_mode mode = split_mode::keep_empty)
+			: source(std::move(source)),
+			  by_set(true),
+			  mode(mode),
+			  delimiter_set(delimiters),
+			  field_set(~delimiters)
+		{
+			if (auto set = this->source.byte_class()) {
+				delimiter_set = delimiter_set & *set;
+				field_set = field_set & *set;
+				pure_source = true;
+			}
+		}
+
+		basic_split_view(basic_filtered_string_view<Pred> source, const filtered_string_view &token)
+			: source(std::move(source)),
+			  pattern(static_cast<std::string>(token)),
+			  failure(pattern.size(), 0)
+		{
+			// failure[i] = length of the longest proper border of pattern[0, i]
+			for (std::size_t i = 1, border = 0; i < pattern.size(); ++i) {
+				while (border > 0 and pattern[i] != pattern[border]) {
+					border = failure[border - 1];
+				}
+				if (pattern[i] == pattern[border]) {
+					++border;
+				}
+				failure[i] = border;
+			}
+		}
+
+		auto begin() const -> iterator {
+			return segment_from(source.window_first);
+		}
+
+		auto end() const -> std::default_sentinel_t {
+			return std::default_sentinel;
+		}
+
+	private:
+		/**
+		 * The segment starting at byte first: up to the next token, or to the end of
+		 * the window when there is none (or the token is empty).
+		 */
+		auto segment_from(const char *first) const -> iterator {
+			auto it = iterator{};
+			it.parent = this;
+			it.done = false;
+			it.segment_first = first;
+			it.segment_last = source.window_last;
+			if (by_set) {
+				if (mode == split_mode::collapse) {
+					it.segment_first = next_in(field_set, first);
+					if (it.segment_first == source.window_last) {
+						it.done = true;
+						return it;
+					}
+				}
+				it.segment_last = next_in(delimiter_set, it.segment_first);
+				it.has_next = it.segment_last != source.window_last;
+				it.next_first = it.segment_last + (it.has_next ? 1 : 0);
+				return it;
+			}
+			if (pattern.empty()) {
+				return it;
+			}
+			std::size_t matched = 0;
+			for (auto pos = source.next_passing(first); pos != source.window_last; pos = source.next_passing(pos + 1)) {
+				while (matched > 0 and *pos != pattern[matched]) {
+					matched = failure[matched - 1];
+				}
+				if (*pos == pattern[matched]) {
+					++matched;
+				}
+				if (matched == pattern.size()) {
+					auto token_first = pos;
+					for (auto back = matched - 1; back > 0; --back) {
+						token_first = source.prev_passing(token_first);
+					}
+					it.segment_last = token_first;
+					it.next_first = pos + 1;
+					it.has_next = true;
+					return it;
+				}
+			}
+			return it;
+		}
+
+		/**
+		 * First passing char at or after from that is in set, or the end of the window
+		 */
+		auto next_in(const byte_set &set, const char *from) const -> const char * {
+			const auto last = source.window_last;
+			from = set.find_first(from, last);
+			if (not pure_source) {
+				while (from != last and not source.passes(from)) {
+					from = set.find_first(from + 1, last);
+				}
+			}
+			return from;
+		}
+
+		basic_filtered_string_view<Pred> source;
+		std::string pattern;
+		std::vector<std::size_t> failure;
+
+		// Splitting on a byte_set: the delimiters and the other bytes, already
+		// intersected with the source predicate when that is a byte_set too
+		bool by_set = false;
+		bool pure_source = false;
+		split_mode mode = split_mode::keep_empty;
+		byte_set delimiter_set;
+		byte_set field_set;
 	};
 
+	template<typename Pred>
+	basic_split_view(basic_filtered_string_view<Pred>, const filtered_string_view &) -> basic_split_view<Pred>;
+
+	template<typename Pred>
+	basic_split_view(basic_filtered_string_view<Pred>, byte_set) -> basic_split_view<Pred>;
+
+	template<typename Pred>
+	basic_split_view(basic_filtered_string_view<Pred>, byte_set, split_mode) -> basic_split_view<Pred>;
+
+	using split_view = basic_split_view<filter>;
+
 	auto compose(const filtered_string_view &fsv, const std::vector<filter> &filts) -> filtered_string_view;
 	auto split(const filtered_string_view &fsv, const filtered_string_view &tok) -> std::vector<filtered_string_view>;
+
+	/**
+	 * Splits on every passing char in delimiters, e.g. split(line, fsv::byte_set::of(",;|")).
+	 * See split_view for the scanning and split_mode for consecutive delimiters.
+	 */
+	auto split(const filtered_string_view &fsv, const byte_set &delimiters, split_mode mode = split_mode::keep_empty)
+	    -> std::vector<filtered_string_view>;
 	auto substr(const filtered_string_view &fsv, int pos = 0, int count = 0) -> filtered_string_view;
 
 } // namespace fsv
 
+/**
+ * Hashes the passing chars a chunk at a time without materialising them. Views that
+ * compare equal hash equal whatever their predicates, and the value is
+ * fsv::content_hash of the materialised string. byte_set predicates are left-packed
+ * with the SIMD compaction kernels before hashing.
+ */
+template<typename Pred>
+	requires std::predicate<const Pred &, const char &>
+struct std::hash<fsv::basic_filtered_string_view<Pred>> {
+	auto operator()(const fsv::basic_filtered_string_view<Pred> &view) const -> std::size_t {
+		auto hasher = fsv::content_hasher{};
+		view.with_predicate([&](const auto &pred) {
+			auto chunks = fsv::detail::chunk_reader{view.window_first, view.window_last, pred};
+			for (auto chunk = chunks.next(); not chunk.empty(); chunk = chunks.next()) {
+				hasher.update(chunk);
+			}
+		});
+		return static_cast<std::size_t>(hasher.digest());
+	}
+};
+
+namespace fsv {
+	/**
+	 * Transparent hash for std::string keyed unordered containers, so find(), count()
+	 * and contains() take a view without building a std::string first:
+	 *
+	 *   auto ids = std::unordered_map<std::string, int, fsv::transparent_hash, fsv::transparent_equal>{};
+	 *   ids.find(fsv::filtered_string_view{line, not_space});
+	 *
+	 * Strings hash with fsv::content_hash, so a string and a view over the same chars
+	 * land in the same bucket. Use it together with transparent_equal.
+	 */
+	struct transparent_hash {
+		using is_transparent = void;
+
+		auto operator()(std::string_view str) const -> std::size_t {
+			return content_hash(str);
+		}
+
+		template<typename Pred>
+		auto operator()(const basic_filtered_string_view<Pred> &view) const -> std::size_t {
+			return std::hash<basic_filtered_string_view<Pred>>{}(view);
+		}
+	};
+
+	/**
+	 * Transparent equality matching transparent_hash. Views are compared against
+	 * strings through a byte_set view of the string, which stores its predicate
+	 * inline, so the comparison does not allocate either.
+	 */
+	struct transparent_equal {
+		using is_transparent = void;
+
+		auto operator()(std::string_view lhs, std::string_view rhs) const -> bool {
+			return lhs == rhs;
+		}
+
+		template<typename Pred>
+		auto operator()(const basic_filtered_string_view<Pred> &lhs, std::string_view rhs) const -> bool {
+			return lhs == basic_filtered_string_view<byte_set>{rhs, byte_set::all()};
+		}
+
+		template<typename Pred>
+		auto operator()(std::string_view lhs, const basic_filtered_string_view<Pred> &rhs) const -> bool {
+			return (*this)(rhs, lhs);
+		}
+
+		template<typename LhsPred, typename RhsPred>
+		auto operator()(const basic_filtered_string_view<LhsPred> &lhs,
+		                const basic_filtered_string_view<RhsPred> &rhs) const -> bool {
+			return lhs == rhs;
+		}
+	};
+} // namespace fsv
+
 #endif // COMP6771_ASS2_FSV_H
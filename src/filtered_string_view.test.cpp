@@ -1,5 +1,7 @@
 #include "./filtered_string_view.h"
 #include <catch2/catch.hpp>
+#include <iomanip>
+#include <unordered_map>
 
 // Helper function to test properties of filtered_string_view
 void test_filtered_string_view_properties(fsv::filtered_string_view& string_view, const char* expected_pointer, size_t expected_size) {
@@ -263,7 +265,51 @@ TEST_CASE("Constructors") {
 
 	}
 
-		
+
+	SECTION("String view and pointer + length constructors") {
+		SECTION("Slice of a larger buffer without a terminator") {
+			const char buffer[] = {'n', 'o', 'i', 's', 'e', 'H', 'e', 'l', 'l', 'o', 'n', 'o', 'i', 's', 'e'};
+			auto string_view = fsv::filtered_string_view(buffer + 5, 5);
+			test_filtered_string_view_properties(string_view, buffer + 5, 5);
+			REQUIRE(string_view.buffer_size() == 5);
+			REQUIRE(static_cast<std::string>(string_view) == "Hello");
+
+			auto sv = std::string_view(buffer + 5, 5);
+			auto from_std_view = fsv::filtered_string_view(sv, [](const char &c) { return c == 'l'; });
+			REQUIRE(from_std_view.data() == buffer + 5);
+			REQUIRE(static_cast<std::string>(from_std_view) == "ll");
+		}
+
+		SECTION("Embedded NULs are ordinary characters") {
+			const auto binary = std::string("He\0llo\0", 8);
+			auto string_view = fsv::filtered_string_view(binary);
+			REQUIRE(string_view.size() == 8);
+			REQUIRE(string_view[2] == '\0');
+			REQUIRE(string_view[5] == 'o');
+			REQUIRE(static_cast<std::string>(string_view) == binary);
+
+			auto no_nul = fsv::filtered_string_view(binary.data(), binary.size(), [](const char &c) { return c != '\0'; });
+			REQUIRE(no_nul.size() == 5);
+			REQUIRE(no_nul == "Hello");
+			REQUIRE(std::string(no_nul.rbegin(), no_nul.rend()) == "olleH");
+		}
+
+		SECTION("compose, split and substr keep the length") {
+			const auto binary = std::string("a\0b|c\0d|e", 9);
+			const auto view = fsv::filtered_string_view(binary);
+			const auto composed = fsv::compose(view, {[](const char &c) { return c != '|'; }});
+			REQUIRE(composed.size() == 7);
+
+			const auto v = fsv::split(view, "|");
+			REQUIRE(v.size() == 3);
+			REQUIRE(v[0] == std::string_view("a\0b", 3));
+			REQUIRE(v[1] == std::string_view("c\0d", 3));
+			REQUIRE(v[2] == "e");
+
+			REQUIRE(fsv::substr(view, 4, 3) == std::string_view("c\0d", 3));
+		}
+	}
+
 	SECTION("Copy constructor") {
 		SECTION ("Initialised by default constructor") {
 			auto string_view = fsv::filtered_string_view();
@@ -683,6 +729,27 @@ TEST_CASE("Member Operator") {
 
 		}
 
+		SECTION("Long strings with byte set and generic predicates") {
+			auto text = std::string{};
+			for (auto i = 0; i < 500; ++i) {
+				text += "Ab, cd\tef;\n";
+			}
+			auto expected = std::string{};
+			for (auto c : text) {
+				if (c >= 'a' && c <= 'z') {
+					expected.push_back(c);
+				}
+			}
+			const auto lower = fsv::byte_set::range('a', 'z');
+			REQUIRE(static_cast<std::string>(fsv::filtered_string_view{text, lower}) == expected);
+			REQUIRE(static_cast<std::string>(fsv::basic_filtered_string_view{text, lower}) == expected);
+			const auto generic = fsv::filtered_string_view{text, [](const char &c) { return c >= 'a' && c <= 'z'; }};
+			REQUIRE(static_cast<std::string>(generic) == expected);
+			REQUIRE(generic.size() == expected.size());
+			REQUIRE(static_cast<std::string>(generic) == expected);
+			REQUIRE(static_cast<std::string>(fsv::filtered_string_view{text}) == text);
+		}
+
 		SECTION("Const correct: can work with const input") {
 			const fsv::filtered_string_view sv = fsv::filtered_string_view("vizsla");
 			auto s = static_cast<std::string>(sv);
@@ -840,6 +907,52 @@ TEST_CASE("Non member operator") {
 		}
 	}
 
+	SECTION("Streaming comparison") {
+		// Longer than a chunk, so the walk has to carry partial chunks across refills
+		auto text = std::string(3000, 'a');
+		text[2500] = 'b';
+		auto spaced = std::string{};
+		for (auto c : text) {
+			spaced += c;
+			spaced += ' ';
+		}
+		const auto not_space = [](const char &c) { return c != ' '; };
+
+		SECTION("Different predicate kinds agree with std::string") {
+			const auto plain = fsv::filtered_string_view{text};
+			const auto with_lambda = fsv::filtered_string_view{spaced, not_space};
+			const auto with_set = fsv::basic_filtered_string_view{spaced, ~fsv::byte_set::of(" ")};
+			REQUIRE(plain == with_lambda);
+			REQUIRE(plain == with_set);
+			REQUIRE(with_set == with_lambda);
+
+			auto smaller = text;
+			smaller[2500] = 'a';
+			REQUIRE(fsv::filtered_string_view{smaller} < with_set);
+			REQUIRE(with_lambda > fsv::filtered_string_view{smaller});
+			REQUIRE(fsv::filtered_string_view{text + "a"} > with_set);
+		}
+
+		SECTION("Same buffer and byte set") {
+			const auto view = fsv::filtered_string_view{spaced, fsv::byte_set::of("b")};
+			const auto copy = view;
+			REQUIRE(view == copy);
+			REQUIRE((view <=> copy) == std::strong_ordering::equal);
+		}
+
+		SECTION("Known sizes that differ") {
+			const auto lhs = fsv::filtered_string_view{"abc"};
+			const auto rhs = fsv::filtered_string_view{"abcd"};
+			REQUIRE(lhs.size() != rhs.size());
+			REQUIRE(lhs != rhs);
+		}
+
+		SECTION("Chars compare as unsigned bytes") {
+			REQUIRE(fsv::filtered_string_view{"a"} < fsv::filtered_string_view{"\xe9"});
+			REQUIRE(fsv::filtered_string_view{"\xe9", not_space} > "z");
+		}
+	}
+
 	SECTION("<< operator") {
 		SECTION("Normal string with custom predicate") {
 			auto s = "c++";
@@ -849,6 +962,24 @@ TEST_CASE("Non member operator") {
 			REQUIRE(stream.str() == s);
 		}
 
+		SECTION("Long string written in chunks") {
+			auto text = std::string{};
+			for (auto i = 0; i < 5000; ++i) {
+				text += static_cast<char>('a' + i % 26);
+			}
+			const auto no_vowels = fsv::filtered_string_view{text, ~fsv::byte_set::of("aeiou")};
+			auto stream = std::stringstream{};
+			stream << no_vowels;
+			REQUIRE(stream.str() == static_cast<std::string>(no_vowels));
+		}
+
+		SECTION("Width and fill are honoured") {
+			const auto view = fsv::filtered_string_view{"a-b-c", [](const char &c) { return c != '-'; }};
+			auto stream = std::stringstream{};
+			stream << std::setw(6) << std::setfill('.') << view << '|' << std::left << std::setw(5) << view << '|';
+			REQUIRE(stream.str() == "...abc|abc..|");
+		}
+
 		SECTION("Empty string with custom predicate") {
 			auto s = "";
 			auto fsv = fsv::filtered_string_view{"", [](const char &c){ return c == 'c' || c == '+'; }};
@@ -946,6 +1077,34 @@ TEST_CASE("Iterators"){
 		REQUIRE(v.empty());
 	}
 
+	SECTION("full pass calls the predicate once per byte") {
+		const auto str = std::string("Rin Tohsaka is the best girl");
+		auto calls = std::size_t{0};
+		const auto s = fsv::filtered_string_view{str, [&calls](const char& c) {
+			++calls;
+			return !(c == 'i' || c == 'o');
+		}};
+		auto out = std::string{};
+		for (const auto &c : s) {
+			out.push_back(c);
+		}
+		REQUIRE(out == "Rn Thsaka s the best grl");
+		REQUIRE(calls == str.size());
+
+		const auto v = std::vector<char>{s.rbegin(), s.rend()};
+		REQUIRE(std::string(v.begin(), v.end()) == "lrg tseb eht s akashT nR");
+	}
+
+	SECTION("post increment and decrement return the old position") {
+		const auto s = fsv::filtered_string_view{"a-b-c", [](const char& c) { return c != '-'; }};
+		auto it = s.begin();
+		REQUIRE(*it++ == 'a');
+		REQUIRE(*it == 'b');
+		REQUIRE(*it-- == 'b');
+		REQUIRE(*it == 'a');
+		REQUIRE(it == s.begin());
+	}
+
 	SECTION("rbegin and rend") {
 		const auto s = fsv::filtered_string_view{"Rin Tohsaka", [](const char& c) { return !(c == 'i' || c == 'o'); }};
 		const auto v = std::vector<char>{s.rbegin(), s.rend()};
@@ -1005,7 +1164,30 @@ TEST_CASE("Functions") {
 
 			auto string_view = fsv::filtered_string_view(e_ref, e_predicate);
 			REQUIRE(string_view.size() == e_string.size());
-			
+
+		}
+
+		SECTION("Size is computed once and carried through copies and moves") {
+			std::string hello_string = "Hello world can you see me?";
+			auto calls = std::size_t{0};
+			fsv::filter counting_predicate = [&calls](const char &c) {
+				++calls;
+				return c == 'e';
+			};
+			auto string_view = fsv::filtered_string_view(hello_string, counting_predicate);
+			REQUIRE(string_view.size() == 4);
+			REQUIRE(calls == hello_string.size());
+
+			REQUIRE(string_view.size() == 4);
+			REQUIRE(!string_view.empty());
+			REQUIRE(calls == hello_string.size());
+
+			auto copied = string_view;
+			REQUIRE(copied.size() == 4);
+			auto moved = std::move(copied);
+			REQUIRE(moved.size() == 4);
+			REQUIRE(copied.size() == 0);
+			REQUIRE(calls == hello_string.size());
 		}
 	}
 
@@ -1169,6 +1351,47 @@ TEST_CASE("Compose") {
 		REQUIRE(sv == "d");
 	}
 
+	SECTION("Byte set filters merge into one table") {
+		const auto fs = fsv::filtered_string_view{"Shawty Destroyer of all time"};
+		const auto vf = std::vector<fsv::filter>{fsv::byte_set::range('a', 'z'),
+		                                         ~fsv::byte_set::of("aeiou"),
+		                                         ~fsv::byte_set::of("t")};
+		const auto sv = fsv::compose(fs, vf);
+		REQUIRE(sv == "hwysryrfllm");
+		REQUIRE(sv.predicate().target<fsv::byte_set>() != nullptr);
+	}
+
+	SECTION("Keeps the window of a substr") {
+		const auto sv = fsv::substr(fsv::filtered_string_view{"abc def ghi"}, 4, 3);
+		const auto composed = fsv::compose(sv, {~fsv::byte_set::of("e")});
+		REQUIRE(composed == "df");
+		REQUIRE(composed.window_begin() == 4);
+	}
+
+	SECTION("Composed predicates flatten into the next compose") {
+		auto calls = 0;
+		const auto sv = fsv::filtered_string_view{"a1b2c3"};
+		const auto counted_digit = [&calls](const char &c) { ++calls; return c >= '0' and c <= '9'; };
+		const auto first = fsv::compose(sv, {counted_digit, ~fsv::byte_set::of("3")});
+		const auto second = fsv::compose(sv, {first.predicate(), ~fsv::byte_set::of("1")});
+		REQUIRE(second.size() == 1);
+		// The merged table rules out everything but 'a', 'b', 'c' and '2' before the lambda runs
+		REQUIRE(calls == 4);
+		REQUIRE(second == "2");
+	}
+
+	SECTION("Opaque filters are still called in order") {
+		auto calls = std::string{};
+		const auto fs = fsv::filtered_string_view{"ab"};
+		const auto vf = std::vector<fsv::filter>{[&calls](const char &c) { calls += '1'; return c == 'a'; },
+		                                         fsv::byte_set::of("ab"),
+		                                         [&calls](const char &) { calls += '2'; return true; }};
+		const auto sv = fsv::compose(fs, vf);
+		REQUIRE(sv.size() == 1);
+		REQUIRE(calls == "121");
+		REQUIRE(sv == "a");
+	}
+
 
 }
 
@@ -1219,6 +1442,44 @@ TEST_CASE("Split") {
 		REQUIRE(v[0] == sv2);
 		REQUIRE(v[1] == sv3);
 	}
+
+	SECTION("Token split by filtered out chars") {
+		const auto sv = fsv::filtered_string_view{"ab-/-/cd-/e", [](const char &c) { return c != '-'; }};
+		const auto v = fsv::split(sv, "//");
+		const auto expected = std::vector<fsv::filtered_string_view>{"ab", "cd/e"};
+		CHECK(v == expected);
+	}
+
+	SECTION("Overlapping matches are taken leftmost first") {
+		const auto v = fsv::split(fsv::filtered_string_view{"aaaaa"}, "aa");
+		const auto expected = std::vector<fsv::filtered_string_view>{"", "", "a"};
+		CHECK(v == expected);
+
+		const auto w = fsv::split(fsv::filtered_string_view{"xabaabababy"}, "abab");
+		const auto expected_w = std::vector<fsv::filtered_string_view>{"xaba", "aby"};
+		CHECK(w == expected_w);
+	}
+
+	SECTION("Segments are windows of the same buffer") {
+		const auto sv = fsv::filtered_string_view{"one,two,three"};
+		const auto v = fsv::split(fsv::substr(sv, 4), ",");
+		REQUIRE(v.size() == 2);
+		REQUIRE(v[0] == "two");
+		REQUIRE(v[0].data() == sv.data());
+		REQUIRE(v[0].window_begin() == 4);
+		REQUIRE(v[1].window_end() == sv.buffer_size());
+	}
+
+	SECTION("Segments only look at their own bytes") {
+		auto calls = 0;
+		const auto sv = fsv::filtered_string_view{"one,two,three", [&calls](const char &) { ++calls; return true; }};
+		const auto v = fsv::split(sv, ",");
+		REQUIRE(v.size() == 3);
+		calls = 0;
+		REQUIRE(v[1].size() == 3);
+		REQUIRE(calls == 3);
+		REQUIRE(v[2] == "three");
+	}
 }
 
 TEST_CASE("Substring") {
@@ -1244,6 +1505,39 @@ TEST_CASE("Substring") {
 		REQUIRE(fsv::substr(sv1, 0, 4) == sv2);
 	}
 
+	SECTION("Window covers the selected chars only") {
+		auto calls = 0;
+		const auto text = std::string("ab-cd-ef-gh");
+		const auto sv = fsv::filtered_string_view{text, [&calls](const char &c) { ++calls; return c != '-'; }};
+		const auto sub = fsv::substr(sv, 2, 3);
+		REQUIRE(sub.data() == sv.data());
+		REQUIRE(sub.window_begin() == 3);
+		REQUIRE(sub.window_end() == 7);
+		calls = 0;
+		REQUIRE(sub.size() == 3);
+		REQUIRE(calls == 4);
+		REQUIRE(sub == "cde");
+		REQUIRE(sub.rank(0) == 0);
+		REQUIRE(sub.rank(6) == 2);
+		REQUIRE(sub.rank(100) == 3);
+		REQUIRE(fsv::substr(sub, 1) == "de");
+	}
+
+	SECTION("Same result with an index") {
+		auto sv = fsv::filtered_string_view{"Siberian Husky", fsv::byte_set::of("aeiu")};
+		sv.build_rank_select_index();
+		const auto sub = fsv::substr(sv, 1, 3);
+		REQUIRE(sub == "eia");
+		REQUIRE(!sub.has_index());
+	}
+
+	SECTION("Out of range") {
+		const auto sv = fsv::filtered_string_view{"Husky"};
+		REQUIRE_THROWS_AS(fsv::substr(sv, 5), std::domain_error);
+		REQUIRE_THROWS_AS(fsv::substr(sv, 3, 3), std::domain_error);
+		REQUIRE_THROWS_AS(fsv::substr(sv, -1, 2), std::domain_error);
+	}
+
 	SECTION("Pos 0, count 0 with default predicate") {
 		const auto predicate = [](const char&) {
 			return false;
@@ -1256,3 +1550,635 @@ TEST_CASE("Substring") {
 
 
 }
+
+TEST_CASE("Rank/select index") {
+	// Deterministic pseudo random buffer, long enough to cover many blocks and select samples
+	auto make_buffer = [](std::size_t n) {
+		auto str = std::string(n, ' ');
+		auto state = std::uint32_t{12345};
+		for (auto &c : str) {
+			state = state * 1103515245u + 12345u;
+			c = static_cast<char>('a' + (state >> 16) % 26);
+		}
+		return str;
+	};
+
+	SECTION("at and operator[] match the unindexed view") {
+		const auto str = make_buffer(20000);
+		const auto pred = [](const char &c) { return c == 'a' || c == 'e' || c == 'z'; };
+		const auto plain = fsv::filtered_string_view{str, pred};
+		auto indexed = fsv::filtered_string_view{str, pred};
+		indexed.build_rank_select_index();
+		REQUIRE(indexed.has_index());
+		REQUIRE(indexed.size() == plain.size());
+		for (int i = 0; i < static_cast<int>(plain.size()); ++i) {
+			REQUIRE(&indexed.at(i) == &plain.at(i));
+			REQUIRE(&indexed[i] == &plain[i]);
+		}
+		REQUIRE_THROWS_AS(indexed.at(static_cast<int>(plain.size())), std::domain_error);
+	}
+
+	SECTION("rank matches the unindexed view") {
+		const auto str = make_buffer(5000);
+		const auto pred = [](const char &c) { return c < 'm'; };
+		const auto plain = fsv::filtered_string_view{str, pred};
+		auto indexed = plain;
+		indexed.build_rank_select_index();
+		for (std::size_t offset = 0; offset <= str.size(); offset += 7) {
+			REQUIRE(indexed.rank(offset) == plain.rank(offset));
+		}
+		REQUIRE(indexed.rank(str.size()) == plain.size());
+	}
+
+	SECTION("sparse and empty filters") {
+		auto str = std::string(10000, '.');
+		str[0] = 'x';
+		str[4999] = 'y';
+		str[9999] = 'z';
+		auto sparse = fsv::filtered_string_view{str, [](const char &c) { return c != '.'; }};
+		sparse.build_rank_select_index();
+		REQUIRE(sparse.size() == 3);
+		REQUIRE(sparse[0] == 'x');
+		REQUIRE(sparse[1] == 'y');
+		REQUIRE(sparse[2] == 'z');
+		REQUIRE(sparse.rank(5000) == 2);
+
+		auto none = fsv::filtered_string_view{str, [](const char &) { return false; }};
+		none.build_rank_select_index();
+		REQUIRE(none.empty());
+		REQUIRE_THROWS_AS(none.at(0), std::domain_error);
+
+		auto empty = fsv::filtered_string_view{};
+		empty.build_rank_select_index();
+		REQUIRE(empty.empty());
+	}
+
+	SECTION("index is shared by copies and dropped by moves") {
+		const auto str = make_buffer(1000);
+		auto indexed = fsv::filtered_string_view{str};
+		indexed.build_rank_select_index();
+		auto copied = indexed;
+		REQUIRE(copied.has_index());
+		REQUIRE(copied[999] == str[999]);
+		auto moved = std::move(copied);
+		REQUIRE(moved.has_index());
+		REQUIRE(!copied.has_index());
+		moved.drop_index();
+		REQUIRE(!moved.has_index());
+		REQUIRE(moved[999] == str[999]);
+	}
+}
+
+TEST_CASE("Sampled index") {
+	auto str = std::string{};
+	for (auto i = 0; i < 3000; ++i) {
+		str.push_back(static_cast<char>('a' + (i * 7 + i / 13) % 26));
+	}
+	const auto pred = [](const char &c) { return c != 'a' && c != 'b' && c != 'q'; };
+	const auto plain = fsv::filtered_string_view{str, pred};
+
+	SECTION("at, operator[] and rank match the unindexed view for several strides") {
+		for (auto stride : {std::size_t{1}, std::size_t{2}, std::size_t{7}, std::size_t{64}, std::size_t{100000}}) {
+			auto indexed = fsv::filtered_string_view{str, pred};
+			indexed.build_sampled_index(stride);
+			REQUIRE(indexed.has_index());
+			REQUIRE(indexed.size() == plain.size());
+			for (int i = 0; i < static_cast<int>(plain.size()); ++i) {
+				REQUIRE(&indexed[i] == &plain[i]);
+			}
+			for (std::size_t offset = 0; offset <= str.size() + 1; offset += 11) {
+				REQUIRE(indexed.rank(offset) == plain.rank(offset));
+			}
+		}
+	}
+
+	SECTION("memory shrinks as the stride grows") {
+		auto dense = fsv::filtered_string_view{str, pred};
+		dense.build_sampled_index(4);
+		auto coarse = fsv::filtered_string_view{str, pred};
+		coarse.build_sampled_index(256);
+		auto bitmap = fsv::filtered_string_view{str, pred};
+		bitmap.build_rank_select_index();
+		REQUIRE(coarse.index_memory_usage() < dense.index_memory_usage());
+		REQUIRE(coarse.index_memory_usage() < bitmap.index_memory_usage());
+		REQUIRE(plain.index_memory_usage() == 0);
+	}
+
+	SECTION("stride 0 is rejected") {
+		auto indexed = fsv::filtered_string_view{str, pred};
+		REQUIRE_THROWS_AS(indexed.build_sampled_index(0), std::domain_error);
+		REQUIRE(!indexed.has_index());
+	}
+}
+
+TEST_CASE("Run index") {
+	auto str = std::string{};
+	for (auto i = 0; i < 3000; ++i) {
+		str.push_back(static_cast<char>('a' + (i * 7 + i / 13) % 26));
+	}
+	const auto pred = [](const char &c) { return c > 'd'; };
+	const auto plain = fsv::filtered_string_view{str, pred};
+	const auto expected = static_cast<std::string>(plain);
+
+	SECTION("at, operator[], rank and iteration match the unindexed view") {
+		auto frozen = fsv::filtered_string_view{str, pred};
+		frozen.build_run_index();
+		REQUIRE(frozen.has_index());
+		REQUIRE(frozen.size() == plain.size());
+		for (int i = 0; i < static_cast<int>(plain.size()); ++i) {
+			REQUIRE(&frozen[i] == &plain[i]);
+		}
+		for (std::size_t offset = 0; offset <= str.size() + 1; offset += 11) {
+			REQUIRE(frozen.rank(offset) == plain.rank(offset));
+		}
+		REQUIRE(std::equal(frozen.begin(), frozen.end(), plain.begin(), plain.end()));
+		REQUIRE(std::equal(frozen.rbegin(), frozen.rend(), plain.rbegin(), plain.rend()));
+		REQUIRE(std::ranges::equal(frozen.runs(), plain.runs()));
+		REQUIRE_THROWS_AS(frozen.at(static_cast<int>(plain.size())), std::domain_error);
+	}
+
+	SECTION("the predicate is not called again") {
+		auto calls = std::size_t{0};
+		auto frozen = fsv::filtered_string_view{str, [&calls, pred](const char &c) { ++calls; return pred(c); }};
+		frozen.build_run_index();
+		REQUIRE(calls == str.size());
+		calls = 0;
+
+		REQUIRE(static_cast<std::string>(frozen) == expected);
+		auto out = std::ostringstream{};
+		out << frozen;
+		REQUIRE(out.str() == expected);
+		REQUIRE(frozen == plain);
+		REQUIRE(std::hash<fsv::filtered_string_view>{}(frozen) == fsv::content_hash(expected));
+		REQUIRE(frozen.find(expected.substr(1000, 20)) == expected.find(expected.substr(1000, 20)));
+		REQUIRE(frozen.ends_with(expected.substr(expected.size() - 30)));
+		REQUIRE(std::distance(frozen.begin(), frozen.end()) == static_cast<std::ptrdiff_t>(expected.size()));
+		REQUIRE(fsv::split(frozen, "k").size() == fsv::split(plain, "k").size());
+		REQUIRE(calls == 0);
+		// Windows of the view, like substr's, do not carry the index over
+		REQUIRE(fsv::substr(frozen, 10, 5) == expected.substr(10, 5));
+	}
+
+	SECTION("memory grows with the runs, not the bytes") {
+		auto long_runs = std::string(5000, 'x') + "." + std::string(5000, 'y');
+		auto frozen = fsv::filtered_string_view{long_runs, [](const char &c) { return c != '.'; }};
+		frozen.build_run_index();
+		REQUIRE(frozen.size() == 10000);
+		REQUIRE(frozen[4999] == 'x');
+		REQUIRE(frozen[5000] == 'y');
+		REQUIRE(std::ranges::distance(frozen.runs()) == 2);
+		auto bitmap = frozen;
+		bitmap.build_rank_select_index();
+		REQUIRE(frozen.index_memory_usage() < bitmap.index_memory_usage() / 10);
+
+		auto none = fsv::filtered_string_view{long_runs, [](const char &) { return false; }};
+		none.build_run_index();
+		REQUIRE(none.empty());
+		REQUIRE(none.begin() == none.end());
+		REQUIRE(std::ranges::empty(none.runs()));
+	}
+}
+
+TEST_CASE("Templated predicate") {
+	const auto is_digit = [](const char &c) { return c >= '0' && c <= '9'; };
+
+	SECTION("Deduces the predicate type") {
+		const auto digits = fsv::basic_filtered_string_view{"ab12cd345", is_digit};
+		STATIC_REQUIRE(!std::is_same_v<std::remove_const_t<decltype(digits)>, fsv::filtered_string_view>);
+		REQUIRE(digits.size() == 5);
+		REQUIRE(digits[3] == '4');
+		REQUIRE(static_cast<std::string>(digits) == "12345");
+		REQUIRE(std::string(digits.begin(), digits.end()) == "12345");
+		REQUIRE(std::string(digits.rbegin(), digits.rend()) == "54321");
+	}
+
+	SECTION("Defaults to the type-erased predicate") {
+		const auto plain = fsv::basic_filtered_string_view{"abc"};
+		STATIC_REQUIRE(std::is_same_v<std::remove_const_t<decltype(plain)>, fsv::filtered_string_view>);
+		REQUIRE(plain == "abc");
+	}
+
+	SECTION("Converts to filtered_string_view") {
+		auto digits = fsv::basic_filtered_string_view{std::string_view{"ab12cd345"}, is_digit};
+		digits.build_rank_select_index();
+		const fsv::filtered_string_view erased = digits;
+		REQUIRE(erased.size() == 5);
+		REQUIRE(erased.has_index());
+		REQUIRE(erased[4] == '5');
+		REQUIRE(erased == digits);
+
+		const auto v = fsv::split(digits, "3");
+		REQUIRE(v.size() == 2);
+		REQUIRE(v[0] == "12");
+		REQUIRE(v[1] == "45");
+	}
+
+	SECTION("Compares with literals and other predicate types") {
+		const auto digits = fsv::basic_filtered_string_view{"a1b2c3", is_digit};
+		const auto letters = fsv::basic_filtered_string_view{"a1b2c3", [](const char &c) { return c >= 'a'; }};
+		REQUIRE(digits == "123");
+		REQUIRE("123" == digits);
+		REQUIRE(digits != "a1b2c3");
+		REQUIRE(letters == "abc");
+		REQUIRE(digits < letters);
+		REQUIRE(letters > digits);
+		REQUIRE(digits == fsv::filtered_string_view{"x1y2z3", is_digit});
+
+		auto stream = std::stringstream{};
+		stream << letters;
+		REQUIRE(stream.str() == "abc");
+	}
+
+	SECTION("Copy and move") {
+		auto digits = fsv::basic_filtered_string_view{"ab12cd345", is_digit};
+		auto copied = digits;
+		copied = digits;
+		REQUIRE(copied == "12345");
+		auto moved = std::move(copied);
+		REQUIRE(moved == "12345");
+		REQUIRE(copied.empty());
+		REQUIRE(copied.data() == nullptr);
+
+		const auto wanted = 'b';
+		auto capturing = fsv::basic_filtered_string_view{"abcabc", [wanted](const char &c) { return c == wanted; }};
+		auto capturing_moved = std::move(capturing);
+		REQUIRE(capturing_moved == "bb");
+		REQUIRE(capturing.empty());
+	}
+}
+
+TEST_CASE("Byte set predicate") {
+	const auto text = std::string("Shawty Destroyer of all time ___");
+	const auto vowels = fsv::byte_set::of("aeiouAEIOU");
+
+	SECTION("Statically typed") {
+		const auto view = fsv::basic_filtered_string_view{text, ~vowels};
+		REQUIRE(view == "Shwty Dstryr f ll tm ___");
+		REQUIRE(view.size() == 24);
+		REQUIRE(view[2] == 'w');
+		REQUIRE(std::string(view.rbegin(), view.rend()) == "___ mt ll f ryrtsD ytwhS");
+	}
+
+	SECTION("Inside the type-erased view") {
+		auto view = fsv::filtered_string_view{text, vowels};
+		REQUIRE(view == "aeoeoaie");
+		REQUIRE(view.size() == 8);
+		REQUIRE(view.at(7) == 'e');
+		REQUIRE(view.rank(10) == 2);
+		view.build_sampled_index(2);
+		REQUIRE(view[6] == 'i');
+	}
+
+	SECTION("The default predicate is the full byte set") {
+		const auto predicate = fsv::filtered_string_view{}.predicate();
+		REQUIRE(fsv::pred::expr(predicate).is_byte_pure());
+		REQUIRE(fsv::pred::expr(predicate).as_byte_set()->is_all());
+		REQUIRE(fsv::compose(fsv::filtered_string_view{"abc"}, {predicate}).predicate().target<fsv::byte_set>() != nullptr);
+	}
+}
+
+TEST_CASE("Hash") {
+	auto text = std::string{};
+	for (auto i = 0; i < 3000; ++i) {
+		text += static_cast<char>('a' + i % 26);
+		text += ' ';
+	}
+	const auto not_space = [](const char &c) { return c != ' '; };
+
+	SECTION("Equals the hash of the materialised string") {
+		const auto view = fsv::filtered_string_view{text, not_space};
+		REQUIRE(std::hash<fsv::filtered_string_view>{}(view) == fsv::content_hash(static_cast<std::string>(view)));
+	}
+
+	SECTION("Equal views hash equal whatever the predicate") {
+		const auto with_lambda = fsv::filtered_string_view{text, not_space};
+		const auto with_set = fsv::basic_filtered_string_view{text, ~fsv::byte_set::of(" ")};
+		const auto erased_set = fsv::filtered_string_view{text, ~fsv::byte_set::of(" ")};
+		const auto plain_string = static_cast<std::string>(with_lambda);
+		const auto plain = fsv::filtered_string_view{plain_string};
+		REQUIRE(with_lambda == with_set);
+		const auto expected = std::hash<fsv::filtered_string_view>{}(plain);
+		REQUIRE(std::hash<fsv::filtered_string_view>{}(with_lambda) == expected);
+		REQUIRE(std::hash<fsv::filtered_string_view>{}(erased_set) == expected);
+		REQUIRE(std::hash<fsv::basic_filtered_string_view<fsv::byte_set>>{}(with_set) == expected);
+	}
+
+	SECTION("Keys an unordered_map") {
+		auto counts = std::unordered_map<fsv::filtered_string_view, int>{};
+		++counts[fsv::filtered_string_view{"a-b", [](const char &c) { return c != '-'; }}];
+		++counts[fsv::filtered_string_view{"ab"}];
+		++counts[fsv::filtered_string_view{"ba"}];
+		REQUIRE(counts.size() == 2);
+		REQUIRE(counts[fsv::filtered_string_view{"ab"}] == 2);
+	}
+}
+
+TEST_CASE("Transparent lookup") {
+	auto ids = std::unordered_map<std::string, int, fsv::transparent_hash, fsv::transparent_equal>{};
+	ids["alpha"] = 1;
+	ids["beta"] = 2;
+	const auto no_dash = [](const char &c) { return c != '-'; };
+
+	SECTION("Views find string keys") {
+		const auto alpha = fsv::filtered_string_view{"al-p-ha", no_dash};
+		REQUIRE(ids.find(alpha) != ids.end());
+		REQUIRE(ids.find(alpha)->second == 1);
+		REQUIRE(ids.contains(fsv::basic_filtered_string_view{"-beta-", no_dash}));
+		REQUIRE(ids.count(fsv::filtered_string_view{"gamma"}) == 0);
+		REQUIRE(ids.count(fsv::filtered_string_view{"alphabet", fsv::byte_set::of("alph")}) == 1);
+	}
+
+	SECTION("Hash agrees between strings and views") {
+		const auto hash = fsv::transparent_hash{};
+		const auto view = fsv::filtered_string_view{"b-e-t-a", no_dash};
+		REQUIRE(hash(std::string("beta")) == hash(view));
+		REQUIRE(hash("beta") == hash(view));
+		REQUIRE(fsv::transparent_equal{}(view, std::string("beta")));
+		REQUIRE(fsv::transparent_equal{}("beta", view));
+		REQUIRE(!fsv::transparent_equal{}(view, "bet"));
+	}
+}
+
+TEST_CASE("Predicate combinators") {
+	using namespace fsv::pred;
+	const auto text = std::string("Shawty Destroyer of all time 42");
+
+	SECTION("Byte-pure expressions give byte set views") {
+		const auto view = fsv::basic_filtered_string_view{text, alpha && !vowel};
+		static_assert(std::is_same_v<std::remove_const_t<decltype(view)>, fsv::basic_filtered_string_view<fsv::byte_set>>);
+		REQUIRE(view == "ShwtyDstryrflltm");
+	}
+
+	SECTION("Mixed expressions inline into the view") {
+		const auto view = fsv::basic_filtered_string_view{text, digit || [](const char &c) { return c == ' '; }};
+		REQUIRE(view == "     42");
+	}
+
+	SECTION("Compose merges byte-pure expressions into one table") {
+		const auto composed = fsv::compose(fsv::filtered_string_view{text}, {alpha && !vowel, !upper});
+		REQUIRE(composed == "hwtystryrflltm");
+		REQUIRE(composed.predicate().target<fsv::byte_set>() != nullptr);
+	}
+}
+
+TEST_CASE("Lazy split") {
+	static_assert(std::ranges::forward_range<fsv::split_view>);
+	static_assert(std::ranges::view<fsv::split_view>);
+
+	SECTION("Same segments as split") {
+		const auto cases = std::vector<std::pair<std::string, std::string>>{
+			{"0xAIOXIMA / 0xHAHAHA", " / "}, {"|a|", "|"}, {"||||", "|"}, {"aaaaa", "aa"}, {"", ","}, {"abc", ""}};
+		for (const auto &[text, token] : cases) {
+			const auto sv = fsv::filtered_string_view{text};
+			auto lazy = std::vector<fsv::filtered_string_view>{};
+			for (auto segment : fsv::split_view{sv, token}) {
+				lazy.push_back(segment);
+			}
+			CHECK(lazy == fsv::split(sv, token));
+		}
+	}
+
+	SECTION("Stops scanning when iteration stops") {
+		auto calls = 0;
+		const auto text = std::string("id,name,") + std::string(1000, 'x');
+		const auto sv = fsv::filtered_string_view{text, [&calls](const char &) { ++calls; return true; }};
+		const auto fields = fsv::split_view{sv, ","};
+		auto it = fields.begin();
+		REQUIRE(*it == "id");
+		REQUIRE(*++it == "name");
+		REQUIRE(calls < 20);
+	}
+
+	SECTION("Works with std::ranges") {
+		const auto fields = fsv::split_view{fsv::filtered_string_view{"a-b, c-d, e"}, ", "};
+		REQUIRE(std::ranges::distance(fields) == 3);
+		auto found = std::ranges::find(fields, fsv::filtered_string_view{"c-d"});
+		REQUIRE(found != fields.end());
+		REQUIRE(fsv::split_view{*found, "-"}.front() == "c");
+	}
+
+	SECTION("Statically typed predicates") {
+		const auto no_space = fsv::basic_filtered_string_view{"a, b ,c", ~fsv::byte_set::of(" ")};
+		auto fields = fsv::basic_split_view{no_space, ","};
+		static_assert(std::is_same_v<std::ranges::range_value_t<decltype(fields)>, fsv::basic_filtered_string_view<fsv::byte_set>>);
+		auto joined = std::string{};
+		for (auto field : fields) {
+			joined += static_cast<std::string>(field) + ";";
+		}
+		REQUIRE(joined == "a;b;c;");
+	}
+}
+
+TEST_CASE("Split by byte set") {
+	const auto delimiters = fsv::byte_set::of(",;|");
+
+	SECTION("Every delimiter ends a segment") {
+		const auto v = fsv::split(fsv::filtered_string_view{",a;b||c,"}, delimiters);
+		const auto expected = std::vector<fsv::filtered_string_view>{"", "a", "b", "", "c", ""};
+		CHECK(v == expected);
+		CHECK(fsv::split(fsv::filtered_string_view{""}, delimiters) == std::vector<fsv::filtered_string_view>{""});
+	}
+
+	SECTION("Collapsing consecutive delimiters") {
+		const auto v = fsv::split(fsv::filtered_string_view{"  the quick\t\tbrown \n fox "}, fsv::pred::space, fsv::split_mode::collapse);
+		const auto expected = std::vector<fsv::filtered_string_view>{"the", "quick", "brown", "fox"};
+		CHECK(v == expected);
+		CHECK(fsv::split(fsv::filtered_string_view{" \t "}, fsv::pred::space, fsv::split_mode::collapse).empty());
+	}
+
+	SECTION("Filtered out delimiters do not split") {
+		const auto no_pipe = [](const char &c) { return c != '|'; };
+		const auto v = fsv::split(fsv::filtered_string_view{"a|b,c", no_pipe}, delimiters);
+		const auto expected = std::vector<fsv::filtered_string_view>{"ab", "c"};
+		CHECK(v == expected);
+
+		const auto statically = fsv::basic_filtered_string_view{"a|b,,c", ~fsv::byte_set::of("|")};
+		auto joined = std::string{};
+		for (auto field : fsv::basic_split_view{statically, delimiters, fsv::split_mode::collapse}) {
+			joined += static_cast<std::string>(field) + ".";
+		}
+		REQUIRE(joined == "ab.c.");
+	}
+
+	SECTION("Long input crosses the vector kernels") {
+		auto text = std::string{};
+		for (auto i = 0; i < 500; ++i) {
+			text += "field" + std::to_string(i) + (i % 7 == 0 ? ";;" : ",");
+		}
+		auto count = std::size_t{0};
+		for (auto field : fsv::split_view{fsv::filtered_string_view{text}, delimiters, fsv::split_mode::collapse}) {
+			REQUIRE(field == "field" + std::to_string(count));
+			++count;
+		}
+		REQUIRE(count == 500);
+		// 572 delimiters, one of them last in the text
+		REQUIRE(fsv::split(fsv::filtered_string_view{text}, delimiters).size() == 573);
+	}
+}
+
+TEST_CASE("Search") {
+	SECTION("Unfiltered views search in place") {
+		const auto v = fsv::filtered_string_view{"abracadabra"};
+		CHECK(v.find("abra") == 0);
+		CHECK(v.find("abra", 1) == 7);
+		CHECK(v.find("abra", 8) == fsv::filtered_string_view::npos);
+		CHECK(v.rfind("abra") == 7);
+		CHECK(v.rfind("abra", 6) == 0);
+		CHECK(v.find("") == 0);
+		CHECK(v.find("", 11) == 11);
+		CHECK(v.find("", 12) == fsv::filtered_string_view::npos);
+		CHECK(v.rfind("") == 11);
+		CHECK(v.contains("cad"));
+		CHECK(not v.contains("cab"));
+		CHECK(v.starts_with("abrac"));
+		CHECK(v.ends_with("dabra"));
+		CHECK(not v.ends_with("xabracadabra"));
+	}
+
+	SECTION("Offsets are filtered offsets") {
+		const auto no_dash = [](const char &c) { return c != '-'; };
+		const auto v = fsv::filtered_string_view{"ab-ra-cad-ab-ra", no_dash};
+		CHECK(v.find("abra") == 0);
+		CHECK(v.rfind("abra") == 7);
+		CHECK(v.find("acad") == 3);
+		CHECK(v.starts_with("abrac"));
+		CHECK(v.ends_with("dabra"));
+		CHECK(not v.starts_with("ab-"));
+
+		const auto statically = fsv::basic_filtered_string_view{"ab-ra-cad-ab-ra", ~fsv::byte_set::of("-")};
+		CHECK(statically.find("dab") == 6);
+		CHECK(statically.ends_with("abra"));
+		CHECK(fsv::basic_filtered_string_view{"---", ~fsv::byte_set::of("-")}.ends_with(""));
+		CHECK(not fsv::basic_filtered_string_view{"---", ~fsv::byte_set::of("-")}.ends_with("-"));
+	}
+
+	SECTION("Windows and indexes") {
+		auto v = fsv::filtered_string_view{"xx abc abc xx", [](const char &c) { return c != ' '; }};
+		const auto inner = fsv::substr(v, 2, 6);
+		CHECK(inner.find("abc") == 0);
+		CHECK(inner.rfind("abc") == 3);
+		CHECK(not inner.contains("xx"));
+		CHECK(not inner.ends_with("x"));
+		v.build_sampled_index(2);
+		CHECK(v.find("abc", 3) == 5);
+		CHECK(v.find("x", 9) == 9);
+		CHECK(v.find("x", 11) == fsv::filtered_string_view::npos);
+	}
+
+	SECTION("Agrees with std::string on periodic text") {
+		auto text = std::string{};
+		for (auto i = 0; i < 3000; ++i) {
+			text += (i % 97 == 0) ? "ab_" : "aab";
+		}
+		const auto keep = ~fsv::byte_set::of("_");
+		const auto filtered = fsv::basic_filtered_string_view{text, keep};
+		const auto plain = static_cast<std::string>(filtered);
+		const auto generic = fsv::filtered_string_view{text, [](const char &c) { return c != '_'; }};
+		const auto needles = {
+		    std::string{"a"}, std::string{"aab"}, std::string{"abaab"}, std::string{"aabaabaabab"},
+		    std::string{"bb"}, plain.substr(1000, 1500), plain.substr(plain.size() - 700)};
+		for (const auto &needle : needles) {
+			CHECK(filtered.find(needle) == plain.find(needle));
+			CHECK(filtered.find(needle, 4321) == plain.find(needle, 4321));
+			CHECK(filtered.rfind(needle) == plain.rfind(needle));
+			CHECK(filtered.rfind(needle, 5000) == plain.rfind(needle, 5000));
+			CHECK(fsv::filtered_string_view{plain}.find(needle, 17) == plain.find(needle, 17));
+			CHECK(fsv::filtered_string_view{plain}.rfind(needle, 4321) == plain.rfind(needle, 4321));
+			CHECK(generic.rfind(needle) == plain.rfind(needle));
+			CHECK(generic.rfind(needle, 2999) == plain.rfind(needle, 2999));
+		}
+		CHECK(filtered.ends_with(plain.substr(plain.size() - 700)));
+		CHECK(filtered.starts_with(plain.substr(0, 700)));
+	}
+
+	SECTION("rfind searches backwards and stops at the last match") {
+		// Matches at every even offset: a forward scan verifying each of them reads the
+		// whole text and is quadratic, a backward one reads from the last candidate
+		auto calls = std::size_t{0};
+		auto periodic = std::string{};
+		for (auto i = 0; i < 1 << 19; ++i) {
+			periodic += "ab";
+		}
+		const auto counted = fsv::filtered_string_view{periodic, [&calls](const char &) {
+			++calls;
+			return true;
+		}};
+		const auto needle = periodic.substr(0, 1 << 16);
+		CHECK(counted.size() == periodic.size());
+
+		calls = 0;
+		CHECK(counted.rfind(needle) == periodic.size() - needle.size());
+		CHECK(calls <= needle.size());
+
+		calls = 0;
+		CHECK(counted.rfind(needle, 12345) == 12344);
+		CHECK(calls <= 3 * (12345 + needle.size()));
+
+		calls = 0;
+		CHECK(counted.rfind(needle.substr(1) + "a") == periodic.size() - needle.size() - 1);
+		CHECK(calls <= 2 * needle.size());
+		CHECK(fsv::filtered_string_view{periodic}.rfind(needle, 12345) == 12344);
+	}
+}
+
+TEST_CASE("Runs") {
+	const auto no_dash = [](const char &c) { return c != '-'; };
+
+	SECTION("Maximal spans of the buffer") {
+		const auto text = std::string{"--ab-c---def-"};
+		const auto v = fsv::filtered_string_view{text, no_dash};
+		auto runs = std::vector<std::string_view>{};
+		for (auto run : v.runs()) {
+			runs.push_back(run);
+		}
+		REQUIRE(runs == std::vector<std::string_view>{"ab", "c", "def"});
+		CHECK(runs.front().data() == text.data() + 2);
+		CHECK(runs.back().data() == text.data() + 9);
+		static_assert(std::ranges::forward_range<decltype(v.runs())>);
+
+		const auto statically = fsv::basic_filtered_string_view{text, ~fsv::byte_set::of("-")};
+		CHECK(std::ranges::equal(statically.runs(), runs));
+		CHECK(std::ranges::distance(fsv::filtered_string_view{text}.runs()) == 1);
+		CHECK(std::ranges::empty(fsv::filtered_string_view{"---", no_dash}.runs()));
+		CHECK(std::ranges::empty(fsv::filtered_string_view{}.runs()));
+	}
+
+	SECTION("Windows cut runs") {
+		const auto v = fsv::substr(fsv::filtered_string_view{"--ab-c---def-", no_dash}, 1, 3);
+		auto joined = std::string{};
+		v.for_each_run([&joined](std::string_view run) { joined += std::string(run) + "|"; });
+		CHECK(joined == "b|c|d|");
+	}
+
+	SECTION("Stopping early") {
+		auto seen = 0;
+		fsv::filtered_string_view{"a-b-c-d", no_dash}.for_each_run([&seen](std::string_view) { return ++seen < 2; });
+		CHECK(seen == 2);
+	}
+
+	SECTION("Long runs stream in place") {
+		auto text = std::string{};
+		for (auto i = 0; i < 40; ++i) {
+			text += std::string(static_cast<std::size_t>(100 + 37 * i), static_cast<char>('a' + i % 26)) + "--";
+		}
+		auto calls = std::size_t{0};
+		const auto counted = [&calls](const char &c) { ++calls; return c != '-'; };
+		const auto dynamic = fsv::filtered_string_view{text, counted};
+		const auto statically = fsv::basic_filtered_string_view{text, ~fsv::byte_set::of("-")};
+		const auto expected = static_cast<std::string>(statically);
+
+		auto out = std::ostringstream{};
+		out << dynamic;
+		CHECK(out.str() == expected);
+		CHECK(calls == text.size());
+		calls = 0;
+		CHECK(static_cast<std::string>(dynamic) == expected);
+		CHECK(std::ranges::distance(dynamic.runs()) == 40);
+		CHECK(calls == 2 * text.size());
+		CHECK(dynamic == statically);
+		CHECK(std::hash<fsv::filtered_string_view>{}(dynamic) == fsv::content_hash(expected));
+		CHECK(std::hash<fsv::basic_filtered_string_view<fsv::byte_set>>{}(statically) == fsv::content_hash(expected));
+		CHECK(statically == fsv::filtered_string_view{expected});
+		CHECK(fsv::filtered_string_view{text, no_dash} < fsv::filtered_string_view{expected + "a"});
+	}
+}
@@ -0,0 +1,70 @@
+#include "./multi_matcher.h"
+
+#include <stdexcept>
+#include <string>
+
+fsv::multi_matcher::multi_matcher(const std::vector<std::string_view> &patterns) {
+    // Alphabet compression: column 0 for bytes in no pattern, one column per other byte
+    for (auto pattern : patterns) {
+        if (pattern.empty()) {
+            throw std::domain_error{"multi_matcher: patterns must not be empty"};
+        }
+        for (auto c : pattern) {
+            auto &column = column_of[static_cast<unsigned char>(c)];
+            if (column == 0) {
+                column = static_cast<std::uint16_t>(classes++);
+            }
+        }
+    }
+
+    // The trie, in the same flat table: 0 stands for "no child" since the root is nobody's child
+    auto own_patterns = std::vector<std::vector<std::uint32_t>>(1);
+    transitions.assign(classes, 0);
+    for (std::size_t id = 0; id < patterns.size(); ++id) {
+        std::uint32_t state = 0;
+        for (auto c : patterns[id]) {
+            auto &next = transitions[state * classes + column_of[static_cast<unsigned char>(c)]];
+            if (next == 0) {
+                next = static_cast<std::uint32_t>(own_patterns.size());
+                own_patterns.emplace_back();
+                transitions.resize(transitions.size() + classes, 0);
+            }
+            state = transitions[state * classes + column_of[static_cast<unsigned char>(c)]];
+        }
+        own_patterns[state].push_back(static_cast<std::uint32_t>(id));
+        pattern_lengths.push_back(patterns[id].size());
+    }
+
+    // Breadth first, so the failure state of every state is complete before it is used:
+    // missing transitions borrow those of the failure state, and outputs append its outputs.
+    const auto state_total = own_patterns.size();
+    auto failure = std::vector<std::uint32_t>(state_total, 0);
+    auto all_outputs = std::vector<std::vector<std::uint32_t>>(state_total);
+    auto queue = std::vector<std::uint32_t>{0};
+    for (std::size_t head = 0; head < queue.size(); ++head) {
+        const auto state = queue[head];
+        all_outputs[state] = own_patterns[state];
+        if (state != 0) {
+            const auto &inherited = all_outputs[failure[state]];
+            all_outputs[state].insert(all_outputs[state].end(), inherited.begin(), inherited.end());
+        }
+        for (std::size_t column = 0; column < classes; ++column) {
+            auto &next = transitions[state * classes + column];
+            const auto fallback = state == 0 ? 0 : transitions[failure[state] * classes + column];
+            if (next != 0) {
+                failure[next] = fallback;
+                queue.push_back(next);
+            }
+            else {
+                next = fallback;
+            }
+        }
+    }
+
+    output_begin.reserve(state_total + 1);
+    for (const auto &state_outputs : all_outputs) {
+        output_begin.push_back(static_cast<std::uint32_t>(outputs.size()));
+        outputs.insert(outputs.end(), state_outputs.begin(), state_outputs.end());
+    }
+    output_begin.push_back(static_cast<std::uint32_t>(outputs.size()));
+}
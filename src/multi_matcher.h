@@ -0,0 +1,123 @@
+#ifndef COMP6771_ASS2_MULTI_MATCHER_H
+#define COMP6771_ASS2_MULTI_MATCHER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "./filtered_string_view.h"
+
+namespace fsv {
+	/**
+	 * Finds any number of patterns in one pass over the passing chars of a view,
+	 * using an Aho-Corasick automaton.
+	 *
+	 * The automaton is a complete DFA stored as one flat table of
+	 * state_count() * class_count() entries. Bytes that occur in no pattern share
+	 * a single column, so a few hundred keywords stay within a few hundred KB. The
+	 * scan is then one table load per passing char, whatever the number of patterns.
+	 *
+	 *   auto keywords = fsv::multi_matcher{{"error", "timeout", "refused"}};
+	 *   for (auto [pattern, offset] : keywords.find_all(payload)) { ... }
+	 *
+	 * Offsets are positions in the filtered string, like operator[] indexes.
+	 */
+	class multi_matcher {
+	public:
+		struct match {
+			// Index of the pattern in the list given to the constructor
+			std::size_t pattern;
+			// Filtered offset of the first char of the occurrence
+			std::size_t offset;
+
+			friend auto operator==(const match &, const match &) -> bool = default;
+		};
+
+		/**
+		 * Throws std::domain_error if a pattern is empty
+		 */
+		explicit multi_matcher(const std::vector<std::string_view> &patterns);
+
+		/**
+		 * Calls on_match(match) for every occurrence of every pattern, overlapping ones
+		 * included, in order of where they end (longer first when two end together).
+		 * If on_match returns bool, returning false stops the scan.
+		 */
+		template<typename Pred, typename F>
+		auto scan(const basic_filtered_string_view<Pred> &view, F &&on_match) const -> void;
+
+		template<typename Pred>
+		auto find_all(const basic_filtered_string_view<Pred> &view) const -> std::vector<match> {
+			auto matches = std::vector<match>{};
+			scan(view, [&matches](const match &found) { matches.push_back(found); });
+			return matches;
+		}
+
+		/**
+		 * Stops at the first occurrence of any pattern
+		 */
+		template<typename Pred>
+		auto contains_any(const basic_filtered_string_view<Pred> &view) const -> bool {
+			auto found_any = false;
+			scan(view, [&found_any](const match &) { found_any = true; return false; });
+			return found_any;
+		}
+
+		auto pattern_count() const -> std::size_t {
+			return pattern_lengths.size();
+		}
+
+		auto state_count() const -> std::size_t {
+			return output_begin.size() - 1;
+		}
+
+		auto class_count() const -> std::size_t {
+			return classes;
+		}
+
+	private:
+		// column_of[b]: the column of byte b in the transition table
+		std::array<std::uint16_t, 256> column_of{};
+		std::size_t classes = 1;
+		// transitions[state * classes + class]: the next state, already following failure links
+		std::vector<std::uint32_t> transitions;
+		// Patterns ending at state s, its own and those of its suffixes:
+		// outputs[output_begin[s] .. output_begin[s + 1])
+		std::vector<std::uint32_t> output_begin;
+		std::vector<std::uint32_t> outputs;
+		std::vector<std::size_t> pattern_lengths;
+	};
+
+	template<typename Pred, typename F>
+	auto multi_matcher::scan(const basic_filtered_string_view<Pred> &view, F &&on_match) const -> void {
+		std::uint32_t state = 0;
+		std::size_t index = 0;
+		auto stopped = false;
+		view.with_predicate([&](const auto &pred) {
+			auto chunks = detail::chunk_reader{view.window_first, view.window_last, pred};
+			for (auto chunk = chunks.next(); not chunk.empty() and not stopped; chunk = chunks.next()) {
+				for (auto c : chunk) {
+					state = transitions[state * classes + column_of[static_cast<unsigned char>(c)]];
+					++index;
+					for (auto out = output_begin[state]; out != output_begin[state + 1] and not stopped; ++out) {
+						const auto found = match{outputs[out], index - pattern_lengths[outputs[out]]};
+						if constexpr (std::is_same_v<std::invoke_result_t<F &, const match &>, bool>) {
+							stopped = not on_match(found);
+						}
+						else {
+							on_match(found);
+						}
+					}
+					if (stopped) {
+						break;
+					}
+				}
+			}
+		});
+	}
+} // namespace fsv
+
+#endif // COMP6771_ASS2_MULTI_MATCHER_H
@@ -0,0 +1,85 @@
+#include "./multi_matcher.h"
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+	using match = fsv::multi_matcher::match;
+
+	// Every occurrence of every pattern in text, by brute force, in the order scan reports them
+	auto reference_matches(const std::vector<std::string_view> &patterns, const std::string &text) -> std::vector<match> {
+		auto matches = std::vector<match>{};
+		for (std::size_t end = 1; end <= text.size(); ++end) {
+			auto ending = std::vector<match>{};
+			for (std::size_t id = 0; id < patterns.size(); ++id) {
+				const auto length = patterns[id].size();
+				if (length <= end and text.compare(end - length, length, patterns[id]) == 0) {
+					ending.push_back({id, end - length});
+				}
+			}
+			std::stable_sort(ending.begin(), ending.end(), [&](const match &lhs, const match &rhs) {
+				return patterns[lhs.pattern].size() > patterns[rhs.pattern].size();
+			});
+			matches.insert(matches.end(), ending.begin(), ending.end());
+		}
+		return matches;
+	}
+}
+
+TEST_CASE("Multi matcher") {
+	SECTION("Classic he/she/his/hers") {
+		const auto matcher = fsv::multi_matcher{{"he", "she", "his", "hers"}};
+		const auto matches = matcher.find_all(fsv::filtered_string_view{"ushers"});
+		const auto expected = std::vector<match>{{1, 1}, {0, 2}, {3, 2}};
+		REQUIRE(matches == expected);
+		REQUIRE(matcher.pattern_count() == 4);
+	}
+
+	SECTION("Offsets are in the filtered string") {
+		const auto matcher = fsv::multi_matcher{{"error", "time"}};
+		const auto payload = fsv::filtered_string_view{"e-r-r-o-r at t-i-m-e", [](const char &c) { return c != '-'; }};
+		const auto expected = std::vector<match>{{0, 0}, {1, 9}};
+		REQUIRE(matcher.find_all(payload) == expected);
+	}
+
+	SECTION("Agrees with brute force, across chunks and predicates") {
+		const auto patterns = std::vector<std::string_view>{"ab", "bab", "abab", "b", "ba", "abab"};
+		auto text = std::string{};
+		for (auto i = 0; i < 1500; ++i) {
+			text += (i * 7 % 5 < 2) ? 'a' : 'b';
+			if (i % 3 == 0) {
+				text += '.';
+			}
+		}
+		const auto matcher = fsv::multi_matcher{patterns};
+		auto filtered = text;
+		std::erase(filtered, '.');
+		const auto expected = reference_matches(patterns, filtered);
+		REQUIRE(matcher.find_all(fsv::filtered_string_view{text, [](const char &c) { return c != '.'; }}) == expected);
+		REQUIRE(matcher.find_all(fsv::basic_filtered_string_view{text, ~fsv::byte_set::of(".")}) == expected);
+		REQUIRE(matcher.find_all(fsv::filtered_string_view{filtered}) == expected);
+	}
+
+	SECTION("Early exit") {
+		const auto text = "xx needle " + std::string(1000, 'y');
+		const auto view = fsv::filtered_string_view{text};
+		const auto matcher = fsv::multi_matcher{{"needle", "y"}};
+		REQUIRE(matcher.contains_any(view));
+		REQUIRE(!fsv::multi_matcher{{"absent"}}.contains_any(fsv::filtered_string_view{"nothing here"}));
+		auto seen = 0;
+		matcher.scan(view, [&seen](const match &) { return ++seen < 3; });
+		REQUIRE(seen == 3);
+	}
+
+	SECTION("Compressed alphabet") {
+		const auto matcher = fsv::multi_matcher{{"abc", "cab"}};
+		REQUIRE(matcher.class_count() == 4);
+		// The root, a, ab, abc, c, ca, cab
+		REQUIRE(matcher.state_count() == 7);
+	}
+
+	SECTION("Empty patterns are rejected") {
+		REQUIRE_THROWS_AS(fsv::multi_matcher({"a", ""}), std::domain_error);
+	}
+}
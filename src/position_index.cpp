@@ -0,0 +1,144 @@
+#include "./position_index.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace {
+    // Offset of the k-th set bit of word (0 based), k < popcount(word)
+    auto select_in_word(std::uint64_t word, std::size_t k) -> std::size_t {
+        std::size_t base = 0;
+        // Skip whole bytes first, at most 8 steps
+        while (true) {
+            auto byte_count = static_cast<std::size_t>(std::popcount(word & 0xFFu));
+            if (k < byte_count) {
+                break;
+            }
+            k -= byte_count;
+            word >>= 8;
+            base += 8;
+        }
+        // Then clear the k lowest set bits of that byte, at most 7 steps
+        for (; k > 0; --k) {
+            word &= word - 1;
+        }
+        return base + static_cast<std::size_t>(std::countr_zero(word));
+    }
+}
+
+auto fsv::detail::rank_select_index::build_directory() -> void {
+    auto block_count = (words.size() + block_words - 1) / block_words;
+    block_ranks.assign(block_count + 1, 0);
+    select_samples.clear();
+
+    std::size_t running = 0;
+    for (std::size_t block = 0; block < block_count; ++block) {
+        block_ranks[block] = running;
+        auto first = block * block_words;
+        auto last = std::min(first + block_words, words.size());
+        for (auto w = first; w < last; ++w) {
+            auto count = static_cast<std::size_t>(std::popcount(words[w]));
+            // Record the block of every select_sample-th passing byte
+            auto next_sample = select_samples.size() * select_sample;
+            while (next_sample < running + count) {
+                select_samples.push_back(block);
+                next_sample += select_sample;
+            }
+            running += count;
+        }
+    }
+    block_ranks[block_count] = running;
+    passing = running;
+}
+
+auto fsv::detail::rank_select_index::rank(std::size_t offset) const -> std::size_t {
+    if (offset >= bit_count) {
+        return passing;
+    }
+    auto word = offset / word_bits;
+    auto block = word / block_words;
+    auto result = static_cast<std::size_t>(block_ranks[block]);
+    for (auto w = block * block_words; w < word; ++w) {
+        result += static_cast<std::size_t>(std::popcount(words[w]));
+    }
+    auto bit = offset % word_bits;
+    if (bit != 0) {
+        result += static_cast<std::size_t>(std::popcount(words[word] << (word_bits - bit)));
+    }
+    return result;
+}
+
+auto fsv::detail::rank_select_index::select(std::size_t index) const -> std::size_t {
+    // The sample table brackets the block; dense buffers land on it directly
+    auto sample = index / select_sample;
+    auto low = select_samples[sample];
+    auto high = sample + 1 < select_samples.size() ? select_samples[sample + 1] + 1 : block_ranks.size() - 1;
+    auto it = std::upper_bound(block_ranks.begin() + static_cast<std::ptrdiff_t>(low),
+                               block_ranks.begin() + static_cast<std::ptrdiff_t>(high),
+                               static_cast<std::uint64_t>(index));
+    auto block = static_cast<std::size_t>(it - block_ranks.begin()) - 1;
+
+    auto remaining = index - static_cast<std::size_t>(block_ranks[block]);
+    auto w = block * block_words;
+    while (true) {
+        auto count = static_cast<std::size_t>(std::popcount(words[w]));
+        if (remaining < count) {
+            break;
+        }
+        remaining -= count;
+        ++w;
+    }
+    return w * word_bits + select_in_word(words[w], remaining);
+}
+
+auto fsv::detail::rank_select_index::memory_usage() const -> std::size_t {
+    return sizeof(*this) + words.capacity() * sizeof(std::uint64_t)
+           + block_ranks.capacity() * sizeof(std::uint64_t) + select_samples.capacity() * sizeof(std::size_t);
+}
+
+auto fsv::detail::sampled_index::checkpoint_before_offset(std::size_t offset) const -> std::pair<std::size_t, std::size_t> {
+    auto it = std::lower_bound(checkpoints.begin(), checkpoints.end(), offset);
+    if (it == checkpoints.begin()) {
+        return {0, 0};
+    }
+    --it;
+    auto number = static_cast<std::size_t>(it - checkpoints.begin());
+    return {number * step, *it};
+}
+
+auto fsv::detail::sampled_index::memory_usage() const -> std::size_t {
+    return sizeof(*this) + checkpoints.capacity() * sizeof(std::size_t);
+}
+
+auto fsv::detail::run_index::run_after(std::size_t offset) const -> std::size_t {
+    const auto next = static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin());
+    if (next > 0 and offset < starts[next - 1] + (before[next] - before[next - 1])) {
+        return next - 1;
+    }
+    return next;
+}
+
+auto fsv::detail::run_index::contains(std::size_t offset) const -> bool {
+    const auto k = run_after(offset);
+    return k < starts.size() and starts[k] <= offset;
+}
+
+auto fsv::detail::run_index::rank(std::size_t offset) const -> std::size_t {
+    if (offset >= bit_count) {
+        return passing;
+    }
+    const auto next = static_cast<std::size_t>(std::upper_bound(starts.begin(), starts.end(), offset) - starts.begin());
+    if (next == 0) {
+        return 0;
+    }
+    return before[next - 1] + std::min(offset - starts[next - 1], before[next] - before[next - 1]);
+}
+
+auto fsv::detail::run_index::select(std::size_t index) const -> std::size_t {
+    const auto runs_end = before.end() - 1;
+    const auto k = static_cast<std::size_t>(std::upper_bound(before.begin(), runs_end, index) - before.begin()) - 1;
+    return starts[k] + (index - before[k]);
+}
+
+auto fsv::detail::run_index::memory_usage() const -> std::size_t {
+    return sizeof(*this) + (starts.capacity() + before.capacity()) * sizeof(std::size_t);
+}
@@ -0,0 +1,227 @@
+#ifndef COMP6771_ASS2_POSITION_INDEX_H
+#define COMP6771_ASS2_POSITION_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace fsv::detail {
+	/**
+	 * Succinct rank/select index over the bytes of a buffer.
+	 *
+	 * One bit per byte says whether it passes the predicate. Every block of 512 bits
+	 * keeps the absolute number of passing bytes before it, and every 512th passing
+	 * byte has its block recorded so select() only has to look at a handful of blocks.
+	 *
+	 * Memory: n/8 bytes of bitmap + n/64 bytes of block counts + a small sample table.
+	 */
+	class rank_select_index {
+	public:
+		static constexpr std::size_t word_bits = 64;
+		static constexpr std::size_t block_words = 8;
+		static constexpr std::size_t block_bits = word_bits * block_words;
+		static constexpr std::size_t select_sample = 512;
+
+		/**
+		 * Evaluates pred once on every byte of [data, data + length).
+		 */
+		template<typename Pred>
+		rank_select_index(const char *data, std::size_t length, const Pred &pred)
+			: bit_count(length),
+			  words((length + word_bits - 1) / word_bits, 0)
+		{
+			for (std::size_t i = 0; i < length; ++i) {
+				if (pred(data[i])) {
+					words[i / word_bits] |= std::uint64_t{1} << (i % word_bits);
+				}
+			}
+			build_directory();
+		}
+
+		/**
+		 * Number of passing bytes in the filtered string
+		 */
+		auto size() const -> std::size_t {
+			return passing;
+		}
+
+		/**
+		 * Number of passing bytes at offsets [0, offset). offset may be up to length.
+		 */
+		auto rank(std::size_t offset) const -> std::size_t;
+
+		/**
+		 * Byte offset of the index-th passing byte (0 based).
+		 * Precondition: index < size()
+		 */
+		auto select(std::size_t index) const -> std::size_t;
+
+		/**
+		 * Bytes used by the index, for callers budgeting memory per view.
+		 */
+		auto memory_usage() const -> std::size_t;
+
+	private:
+		auto build_directory() -> void;
+
+		std::size_t bit_count;
+		std::size_t passing = 0;
+		std::vector<std::uint64_t> words;
+		// block_ranks[b] = passing bytes before block b, with one trailing total entry
+		std::vector<std::uint64_t> block_ranks;
+		// select_samples[k] = block holding passing byte number k * select_sample
+		std::vector<std::size_t> select_samples;
+	};
+
+	/**
+	 * Checkpoint index that remembers the byte offset of every stride-th passing byte.
+	 *
+	 * Memory is size() / stride offsets, so the caller trades memory for latency:
+	 * a lookup jumps to the nearest checkpoint and then walks over fewer than stride
+	 * passing bytes with the predicate.
+	 */
+	class sampled_index {
+	public:
+		/**
+		 * Evaluates pred once on every byte of [data, data + length).
+		 * Precondition: stride > 0
+		 */
+		template<typename Pred>
+		sampled_index(const char *data, std::size_t length, const Pred &pred, std::size_t stride)
+			: step(stride)
+		{
+			for (std::size_t i = 0; i < length; ++i) {
+				if (pred(data[i])) {
+					if (passing % step == 0) {
+						checkpoints.push_back(i);
+					}
+					++passing;
+				}
+			}
+			checkpoints.shrink_to_fit();
+		}
+
+		auto size() const -> std::size_t {
+			return passing;
+		}
+
+		auto stride() const -> std::size_t {
+			return step;
+		}
+
+		/**
+		 * Byte offset of passing byte number (index / stride) * stride.
+		 * Precondition: index < size()
+		 */
+		auto checkpoint_for_index(std::size_t index) const -> std::size_t {
+			return checkpoints[index / step];
+		}
+
+		/**
+		 * Nearest checkpoint below offset, as {passing bytes before it, its byte offset}.
+		 * Returns {0, 0} when no checkpoint lies below offset: there are no passing
+		 * bytes before the first checkpoint, so scanning from the start is exact.
+		 */
+		auto checkpoint_before_offset(std::size_t offset) const -> std::pair<std::size_t, std::size_t>;
+
+		auto memory_usage() const -> std::size_t;
+
+	private:
+		std::size_t step;
+		std::size_t passing = 0;
+		std::vector<std::size_t> checkpoints;
+	};
+
+	/**
+	 * Run list index: every maximal run of passing bytes as its start offset, with the
+	 * number of passing bytes before it (so run k is before[k + 1] - before[k] long).
+	 *
+	 * Memory is two offsets per run, however long the runs are. rank, select and
+	 * finding the run around an offset are binary searches over the runs, so once it
+	 * is built nothing needs the predicate any more.
+	 */
+	class run_index {
+	public:
+		/**
+		 * Evaluates pred once on every byte of [data, data + length).
+		 */
+		template<typename Pred>
+		run_index(const char *data, std::size_t length, const Pred &pred)
+			: bit_count(length)
+		{
+			std::size_t i = 0;
+			while (i < length) {
+				while (i < length and not pred(data[i])) {
+					++i;
+				}
+				if (i == length) {
+					break;
+				}
+				const auto first = i++;
+				while (i < length and pred(data[i])) {
+					++i;
+				}
+				starts.push_back(first);
+				before.push_back(passing);
+				passing += i - first;
+				// data[i] ended the run, so it is known to fail
+				if (i < length) {
+					++i;
+				}
+			}
+			before.push_back(passing);
+			starts.shrink_to_fit();
+			before.shrink_to_fit();
+		}
+
+		auto size() const -> std::size_t {
+			return passing;
+		}
+
+		auto run_count() const -> std::size_t {
+			return starts.size();
+		}
+
+		/**
+		 * {byte offset, length} of run k.
+		 * Precondition: k < run_count()
+		 */
+		auto run(std::size_t k) const -> std::pair<std::size_t, std::size_t> {
+			return {starts[k], before[k + 1] - before[k]};
+		}
+
+		/**
+		 * The first run that ends after offset, i.e. the one holding offset if any,
+		 * or run_count() if there is none.
+		 */
+		auto run_after(std::size_t offset) const -> std::size_t;
+
+		auto contains(std::size_t offset) const -> bool;
+
+		/**
+		 * Number of passing bytes at offsets [0, offset). offset may be up to length.
+		 */
+		auto rank(std::size_t offset) const -> std::size_t;
+
+		/**
+		 * Byte offset of the index-th passing byte (0 based).
+		 * Precondition: index < size()
+		 */
+		auto select(std::size_t index) const -> std::size_t;
+
+		auto memory_usage() const -> std::size_t;
+
+	private:
+		std::size_t bit_count;
+		std::size_t passing = 0;
+		std::vector<std::size_t> starts;
+		// before[k] = passing bytes before run k, with one trailing total entry
+		std::vector<std::size_t> before;
+	};
+
+	using position_index = std::variant<rank_select_index, sampled_index, run_index>;
+} // namespace fsv::detail
+
+#endif // COMP6771_ASS2_POSITION_INDEX_H
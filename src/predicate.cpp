@@ -0,0 +1,157 @@
+#include "./predicate.h"
+
+#include <algorithm>
+#include <utility>
+
+fsv::pred::expr::expr(byte_set set)
+    : node(kind::set_term),
+      set(set)
+{
+
+}
+
+fsv::pred::expr::expr(filter f)
+    : node(kind::opaque_term)
+{
+    if (auto table = f.target<byte_set>()) {
+        node = kind::set_term;
+        set = *table;
+    }
+    else if (f.target<detail::pass_all>()) {
+        node = kind::set_term;
+        set = byte_set::all();
+    }
+    else if (auto compiled = f.target<expr>()) {
+        // Adopt the tree of an earlier compile() rather than nesting it behind another call
+        *this = *compiled;
+    }
+    else {
+        opaque = std::move(f);
+    }
+}
+
+fsv::pred::expr::expr(kind node, byte_set set, std::vector<expr> terms)
+    : node(node),
+      set(set),
+      terms(std::move(terms))
+{
+
+}
+
+auto fsv::pred::expr::operator()(const char &c) const -> bool {
+    const auto term_holds = [&c](const expr &term) { return term(c); };
+    switch (node) {
+    case kind::set_term:
+        return set.contains(c);
+    case kind::opaque_term:
+        return opaque(c);
+    case kind::negation:
+        return not terms.front()(c);
+    case kind::conjunction:
+        return set.contains(c) and std::all_of(terms.begin(), terms.end(), term_holds);
+    case kind::disjunction:
+        return set.contains(c) or std::any_of(terms.begin(), terms.end(), term_holds);
+    }
+    return false;
+}
+
+auto fsv::pred::expr::is_byte_pure() const -> bool {
+    return node == kind::set_term;
+}
+
+auto fsv::pred::expr::as_byte_set() const -> const byte_set * {
+    return is_byte_pure() ? &set : nullptr;
+}
+
+auto fsv::pred::expr::compile() const -> filter {
+    if (is_byte_pure()) {
+        return set;
+    }
+    return *this;
+}
+
+// all_of and any_of are duals: the table starts at the identity of the operation,
+// byte-pure terms (and the tables of nested nodes of the same kind) merge into it,
+// everything else is kept in order.
+auto fsv::pred::all_of(std::vector<expr> terms) -> expr {
+    auto set = byte_set::all();
+    auto rest = std::vector<expr>{};
+    for (auto &term : terms) {
+        if (term.node == expr::kind::set_term) {
+            set = set & term.set;
+        }
+        else if (term.node == expr::kind::conjunction) {
+            set = set & term.set;
+            std::move(term.terms.begin(), term.terms.end(), std::back_inserter(rest));
+        }
+        else {
+            rest.push_back(std::move(term));
+        }
+    }
+    if (set.is_empty() or rest.empty()) {
+        return set;
+    }
+    if (set.is_all() and rest.size() == 1) {
+        return std::move(rest.front());
+    }
+    return expr(expr::kind::conjunction, set, std::move(rest));
+}
+
+auto fsv::pred::any_of(std::vector<expr> terms) -> expr {
+    auto set = byte_set{};
+    auto rest = std::vector<expr>{};
+    for (auto &term : terms) {
+        if (term.node == expr::kind::set_term) {
+            set = set | term.set;
+        }
+        else if (term.node == expr::kind::disjunction) {
+            set = set | term.set;
+            std::move(term.terms.begin(), term.terms.end(), std::back_inserter(rest));
+        }
+        else {
+            rest.push_back(std::move(term));
+        }
+    }
+    if (set.is_all() or rest.empty()) {
+        return set;
+    }
+    if (set.is_empty() and rest.size() == 1) {
+        return std::move(rest.front());
+    }
+    return expr(expr::kind::disjunction, set, std::move(rest));
+}
+
+// Pushed down with De Morgan, so only opaque terms are ever wrapped in a negation
+auto fsv::pred::not_(expr term) -> expr {
+    switch (term.node) {
+    case expr::kind::set_term:
+        return ~term.set;
+    case expr::kind::negation:
+        return std::move(term.terms.front());
+    case expr::kind::conjunction:
+    case expr::kind::disjunction: {
+        auto negated = std::vector<expr>{~term.set};
+        for (auto &operand : term.terms) {
+            negated.push_back(not_(std::move(operand)));
+        }
+        return term.node == expr::kind::conjunction ? any_of(std::move(negated)) : all_of(std::move(negated));
+    }
+    case expr::kind::opaque_term:
+        break;
+    }
+    auto operand = std::vector<expr>{};
+    operand.push_back(std::move(term));
+    return expr(expr::kind::negation, byte_set{}, std::move(operand));
+}
+
+auto fsv::pred::in_range(char first, char last) -> expr {
+    return byte_set::range(first, last);
+}
+
+auto fsv::pred::one_of(std::string_view chars) -> expr {
+    return byte_set::of(chars);
+}
+
+auto fsv::pred::tabulate(const filter &f) -> expr {
+    return byte_set::from(f);
+}
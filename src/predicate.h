@@ -0,0 +1,274 @@
+#ifndef COMP6771_ASS2_PREDICATE_H
+#define COMP6771_ASS2_PREDICATE_H
+
+#include <concepts>
+#include <functional>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "./byte_set.h"
+
+namespace fsv {
+	using filter = std::function<bool(const char &)>;
+
+	namespace detail {
+		/**
+		 * The default predicate of the type-erased view: every byte passes. An empty
+		 * type rather than byte_set::all() itself, so std::function keeps it inline and
+		 * default views are built and copied without allocating. Views and pred::expr
+		 * treat it as the full byte_set.
+		 */
+		struct pass_all {
+			constexpr auto operator()(const char &) const -> bool {
+				return true;
+			}
+		};
+
+		inline constexpr byte_set full_byte_set = byte_set::all();
+	} // namespace detail
+
+	namespace pred {
+		// Compile-time combinators.
+		//
+		// &&, || and ! on two byte_sets fold straight into a byte_set, so an expression
+		// of byte-pure terms is a constant table with no trace of how it was built:
+		//
+		//   constexpr fsv::byte_set consonant = fsv::pred::alpha && !fsv::pred::vowel;
+		//   auto view = fsv::basic_filtered_string_view{text, consonant};   // a byte_set view
+		//
+		// As soon as another predicate joins in, they build an expression template
+		// instead, whose type spells out the whole tree so it inlines into the scanning
+		// loops of a basic_filtered_string_view:
+		//
+		//   auto view = fsv::basic_filtered_string_view{text, fsv::pred::digit || is_separator};
+
+		// ASCII character classes, independent of the C locale
+		inline constexpr byte_set lower = byte_set::range('a', 'z');
+		inline constexpr byte_set upper = byte_set::range('A', 'Z');
+		inline constexpr byte_set alpha = lower | upper;
+		inline constexpr byte_set digit = byte_set::range('0', '9');
+		inline constexpr byte_set alnum = alpha | digit;
+		inline constexpr byte_set xdigit = digit | byte_set::range('a', 'f') | byte_set::range('A', 'F');
+		inline constexpr byte_set space = byte_set::of(" \t\n\v\f\r");
+		inline constexpr byte_set punct = byte_set::range('!', '~') & ~alnum;
+		inline constexpr byte_set vowel = byte_set::of("aeiouAEIOU");
+
+		template<typename Lhs, typename Rhs>
+		struct and_term {
+			Lhs lhs;
+			Rhs rhs;
+
+			constexpr auto operator()(const char &c) const -> bool {
+				return lhs(c) and rhs(c);
+			}
+		};
+
+		template<typename Lhs, typename Rhs>
+		struct or_term {
+			Lhs lhs;
+			Rhs rhs;
+
+			constexpr auto operator()(const char &c) const -> bool {
+				return lhs(c) or rhs(c);
+			}
+		};
+
+		template<typename Operand>
+		struct not_term {
+			Operand operand;
+
+			constexpr auto operator()(const char &c) const -> bool {
+				return not operand(c);
+			}
+		};
+
+		template<typename T>
+		inline constexpr bool is_node = false;
+		template<typename Lhs, typename Rhs>
+		inline constexpr bool is_node<and_term<Lhs, Rhs>> = true;
+		template<typename Lhs, typename Rhs>
+		inline constexpr bool is_node<or_term<Lhs, Rhs>> = true;
+		template<typename Operand>
+		inline constexpr bool is_node<not_term<Operand>> = true;
+
+		/**
+		 * A byte_set or a combinator node: what the operators below take on at least one side
+		 */
+		template<typename T>
+		concept term = std::same_as<T, byte_set> or is_node<T>;
+
+		template<typename T>
+		concept operand = std::predicate<const T &, const char &>;
+
+		template<operand Lhs, operand Rhs>
+			requires(term<Lhs> or term<Rhs>)
+		constexpr auto operator&&(Lhs lhs, Rhs rhs) {
+			if constexpr (std::same_as<Lhs, byte_set> and std::same_as<Rhs, byte_set>) {
+				return lhs & rhs;
+			}
+			else {
+				return and_term<Lhs, Rhs>{std::move(lhs), std::move(rhs)};
+			}
+		}
+
+		template<operand Lhs, operand Rhs>
+			requires(term<Lhs> or term<Rhs>)
+		constexpr auto operator||(Lhs lhs, Rhs rhs) {
+			if constexpr (std::same_as<Lhs, byte_set> and std::same_as<Rhs, byte_set>) {
+				return lhs | rhs;
+			}
+			else {
+				return or_term<Lhs, Rhs>{std::move(lhs), std::move(rhs)};
+			}
+		}
+
+		template<term Operand>
+		constexpr auto operator!(Operand operand) {
+			if constexpr (std::same_as<Operand, byte_set>) {
+				return ~operand;
+			}
+			else if constexpr (requires { operand.operand; }) {
+				return std::move(operand.operand);
+			}
+			else {
+				return not_term<Operand>{std::move(operand)};
+			}
+		}
+		/**
+		 * A predicate expression built from all_of, any_of, not_, in_range and one_of.
+		 *
+		 * Expressions are simplified as they are built: terms that only depend on the
+		 * byte (byte_sets, in_range, one_of, filters holding a byte_set) are merged into
+		 * one 256-bit table per all_of/any_of, constants fold away, nested all_of/any_of
+		 * flatten and not_ is pushed down to the leaves. An expression made of byte-pure
+		 * terms alone compiles to a single byte_set, which views scan with the SIMD kernels.
+		 *
+		 *   auto word = pred::all_of({pred::not_(pred::one_of(" \t")), pred::in_range('!', '~')});
+		 *   auto view = fsv::filtered_string_view{text, word.compile()};
+		 *
+		 * Opaque filters are kept as they are and called in their original order, after
+		 * the merged table of their all_of/any_of has been checked.
+		 */
+		class expr {
+		public:
+			/**
+			 * A byte-pure term
+			 */
+			expr(byte_set set);
+
+			/**
+			 * An opaque term, unless the filter holds a byte_set (or the default
+			 * predicate) or the result of compile(), whose tree is taken over as is
+			 */
+			expr(filter f);
+
+			template<typename F>
+				requires(std::predicate<const F &, const char &>
+				         and not std::is_same_v<std::remove_cvref_t<F>, expr>
+				         and not std::is_same_v<std::remove_cvref_t<F>, byte_set>
+				         and not std::is_same_v<std::remove_cvref_t<F>, filter>)
+			expr(F &&f)
+				: expr(lift(std::forward<F>(f)))
+			{
+
+			}
+
+			auto operator()(const char &c) const -> bool;
+
+			/**
+			 * True when the expression has been reduced to one byte table
+			 */
+			auto is_byte_pure() const -> bool;
+
+			/**
+			 * The table of a byte-pure expression, otherwise nullptr
+			 */
+			auto as_byte_set() const -> const byte_set *;
+
+			/**
+			 * The expression as a filter: the byte_set itself when byte-pure, so views
+			 * recognise it, otherwise a closure over the simplified tree.
+			 */
+			auto compile() const -> filter;
+
+			friend auto all_of(std::vector<expr> terms) -> expr;
+			friend auto any_of(std::vector<expr> terms) -> expr;
+			friend auto not_(expr term) -> expr;
+
+		private:
+			enum class kind { set_term, opaque_term, negation, conjunction, disjunction };
+
+			expr(kind node, byte_set set, std::vector<expr> terms);
+
+			/**
+			 * Combinator nodes keep their structure, so their byte-pure parts still merge;
+			 * any other callable becomes an opaque term.
+			 */
+			template<typename F>
+			static auto lift(F &&f) -> expr;
+
+			kind node;
+			// The table of a set_term, or the merged byte-pure terms of a conjunction/disjunction
+			byte_set set;
+			filter opaque;
+			// The remaining terms: the single operand of a negation, or the
+			// non byte-pure operands of a conjunction/disjunction
+			std::vector<expr> terms;
+		};
+
+		/**
+		 * True when every term is; all_of({}) is always true
+		 */
+		auto all_of(std::vector<expr> terms) -> expr;
+
+		/**
+		 * True when any term is; any_of({}) is always false
+		 */
+		auto any_of(std::vector<expr> terms) -> expr;
+
+		auto not_(expr term) -> expr;
+
+		/**
+		 * Bytes in [first, last], compared as unsigned bytes
+		 */
+		auto in_range(char first, char last) -> expr;
+
+		auto one_of(std::string_view chars) -> expr;
+
+		/**
+		 * Tabulates f into a byte-pure term. Only valid when f depends on the char alone,
+		 * see byte_set::from.
+		 */
+		auto tabulate(const filter &f) -> expr;
+
+		template<typename F>
+		auto expr::lift(F &&f) -> expr {
+			using node_type = std::remove_cvref_t<F>;
+			if constexpr (is_node<node_type> and requires { f.operand; }) {
+				return not_(expr(f.operand));
+			}
+			else if constexpr (is_node<node_type>) {
+				auto operands = std::vector<expr>{};
+				operands.emplace_back(f.lhs);
+				operands.emplace_back(f.rhs);
+				if constexpr (std::is_same_v<node_type, and_term<decltype(f.lhs), decltype(f.rhs)>>) {
+					return all_of(std::move(operands));
+				}
+				else {
+					return any_of(std::move(operands));
+				}
+			}
+			else {
+				return expr(filter(std::forward<F>(f)));
+			}
+		}
+	} // namespace pred
+
+	// So argument dependent lookup finds the combinators for byte_set operands
+	using pred::operator&&;
+	using pred::operator||;
+	using pred::operator!;
+} // namespace fsv
+
+#endif // COMP6771_ASS2_PREDICATE_H
@@ -0,0 +1,107 @@
+#include "./predicate.h"
+#include <catch2/catch.hpp>
+
+#include <string>
+#include <vector>
+
+namespace {
+	// Every byte value the expression accepts, in order
+	auto accepted(const fsv::pred::expr &e) -> std::string {
+		auto chars = std::string{};
+		for (unsigned b = 0; b < 256; ++b) {
+			if (e(static_cast<char>(b))) {
+				chars += static_cast<char>(b);
+			}
+		}
+		return chars;
+	}
+}
+
+TEST_CASE("Predicate expressions") {
+	const auto is_digit = [](const char &c) { return c >= '0' and c <= '9'; };
+
+	SECTION("Byte-pure terms compile to one table") {
+		const auto e = fsv::pred::all_of({fsv::pred::in_range('a', 'z'),
+		                                  fsv::pred::not_(fsv::pred::one_of("aeiou")),
+		                                  fsv::pred::any_of({fsv::pred::one_of("bcd"), fsv::pred::one_of("xyz")})});
+		REQUIRE(e.is_byte_pure());
+		REQUIRE(*e.as_byte_set() == fsv::byte_set::of("bcdxyz"));
+		REQUIRE(e.compile().target<fsv::byte_set>() != nullptr);
+	}
+
+	SECTION("Filters holding a byte set are byte-pure") {
+		const auto e = fsv::pred::any_of({fsv::filter{fsv::byte_set::of("ab")}, fsv::byte_set::of("c")});
+		REQUIRE(e.is_byte_pure());
+		REQUIRE(accepted(e) == "abc");
+	}
+
+	SECTION("Constants fold") {
+		REQUIRE(fsv::pred::all_of({}).as_byte_set()->is_all());
+		REQUIRE(fsv::pred::any_of({}).as_byte_set()->is_empty());
+		REQUIRE(fsv::pred::all_of({is_digit, fsv::byte_set{}}).is_byte_pure());
+		REQUIRE(fsv::pred::any_of({is_digit, fsv::byte_set::all()}).as_byte_set()->is_all());
+		REQUIRE(accepted(fsv::pred::all_of({is_digit, fsv::byte_set::all()})) == "0123456789");
+	}
+
+	SECTION("Opaque terms keep their meaning") {
+		const auto e = fsv::pred::all_of({fsv::pred::in_range('0', '7'), fsv::pred::not_(is_digit)});
+		REQUIRE(!e.is_byte_pure());
+		REQUIRE(accepted(e).empty());
+
+		const auto f = fsv::pred::any_of({fsv::pred::one_of("ab"), is_digit});
+		REQUIRE(accepted(f) == "0123456789ab");
+		REQUIRE(accepted(fsv::pred::not_(fsv::pred::not_(f))) == accepted(f));
+
+		const auto g = fsv::pred::not_(f);
+		REQUIRE(accepted(g).size() == 256 - 12);
+		REQUIRE(g('c'));
+		REQUIRE(!g('5'));
+		REQUIRE(!g.compile()('a'));
+	}
+
+	SECTION("Tabulated filters are byte-pure") {
+		const auto e = fsv::pred::all_of({fsv::pred::tabulate(is_digit), fsv::pred::not_(fsv::pred::one_of("0"))});
+		REQUIRE(e.is_byte_pure());
+		REQUIRE(accepted(e) == "123456789");
+	}
+}
+
+TEST_CASE("Compile-time combinators") {
+	using namespace fsv::pred;
+
+	SECTION("Byte-pure expressions are constant tables") {
+		constexpr auto consonant = alpha && !vowel;
+		static_assert(std::is_same_v<std::remove_const_t<decltype(consonant)>, fsv::byte_set>);
+		static_assert(consonant.count() == 42);
+		static_assert(consonant('b') and not consonant('a') and not consonant('1'));
+		static_assert((digit || xdigit) == xdigit);
+		static_assert((!!space) == space);
+		static_assert(punct.count() == 32);
+	}
+
+	SECTION("Other predicates build expression templates") {
+		const auto is_dash = [](const char &c) { return c == '-'; };
+		const auto e = digit || is_dash;
+		static_assert(std::is_same_v<std::remove_const_t<decltype(e)>, or_term<fsv::byte_set, std::remove_const_t<decltype(is_dash)>>>);
+		REQUIRE(e('7'));
+		REQUIRE(e('-'));
+		REQUIRE(!e('x'));
+
+		const auto f = !(alpha && is_dash);
+		REQUIRE(f('-'));
+		REQUIRE(!(!f)('-'));
+	}
+
+	SECTION("Expression templates keep their byte-pure parts in expr") {
+		const auto is_dash = [](const char &c) { return c == '-'; };
+		const auto e = fsv::pred::expr(alpha && !vowel && is_dash);
+		REQUIRE(!e.is_byte_pure());
+		REQUIRE(accepted(e).empty());
+
+		const auto f = fsv::pred::expr((alpha || is_dash) && !alpha);
+		REQUIRE(accepted(f) == "-");
+
+		REQUIRE(fsv::pred::expr(!!(digit || is_dash)).compile()('-'));
+		REQUIRE(fsv::pred::any_of({alpha && is_dash, digit}).compile()('5'));
+	}
+}
@@ -0,0 +1,579 @@
+#include "./regex.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "./content_hash.h"
+#include "./predicate.h"
+
+namespace {
+    using program = fsv::detail::regex_program;
+    using op = program::op;
+
+    constexpr int unbounded = -1;
+    constexpr int max_repeat = 1000;
+    constexpr std::size_t max_depth = 256;
+    constexpr std::size_t max_instructions = std::size_t{1} << 16;
+
+    struct node {
+        enum class kind { set, concat, alternate, repeat, begin, end };
+
+        kind type = kind::concat;
+        fsv::byte_set set{};
+        std::vector<node> children{};
+        int min = 0;
+        int max = 0;
+        bool greedy = true;
+    };
+
+    [[noreturn]] auto fail(std::string_view what, std::size_t at) -> void {
+        throw std::domain_error{"fsv::regex: " + std::string(what) + " at offset " + std::to_string(at)};
+    }
+
+    const auto word = fsv::pred::alnum | fsv::byte_set::of("_");
+
+    class parser {
+    public:
+        explicit parser(std::string_view pattern)
+            : pattern(pattern)
+        {
+
+        }
+
+        auto parse() -> node {
+            auto root = alternation();
+            if (at != pattern.size()) {
+                fail("unmatched )", at);
+            }
+            return root;
+        }
+
+    private:
+        auto done() const -> bool {
+            return at == pattern.size();
+        }
+
+        auto peek() const -> char {
+            return pattern[at];
+        }
+
+        auto alternation() -> node {
+            if (++depth > max_depth) {
+                fail("groups nested too deeply", at);
+            }
+            auto first = concatenation();
+            if (done() or peek() != '|') {
+                --depth;
+                return first;
+            }
+            auto alternatives = node{node::kind::alternate};
+            alternatives.children.push_back(std::move(first));
+            while (not done() and peek() == '|') {
+                ++at;
+                alternatives.children.push_back(concatenation());
+            }
+            --depth;
+            return alternatives;
+        }
+
+        auto concatenation() -> node {
+            auto sequence = node{node::kind::concat};
+            while (not done() and peek() != '|' and peek() != ')') {
+                sequence.children.push_back(repetition());
+            }
+            if (sequence.children.size() == 1) {
+                return std::move(sequence.children.front());
+            }
+            return sequence;
+        }
+
+        auto repetition() -> node {
+            auto operand = atom();
+            if (done()) {
+                return operand;
+            }
+            auto min = 0;
+            auto max = unbounded;
+            switch (peek()) {
+            case '*': break;
+            case '+': min = 1; break;
+            case '?': max = 1; break;
+            case '{': {
+                const auto open = at;
+                ++at;
+                min = number();
+                max = min;
+                if (not done() and peek() == ',') {
+                    ++at;
+                    max = (not done() and peek() == '}') ? unbounded : number();
+                }
+                if (done() or peek() != '}') {
+                    fail("unterminated {", open);
+                }
+                if (max != unbounded and max < min) {
+                    fail("{n,m} with m < n", open);
+                }
+                break;
+            }
+            default: return operand;
+            }
+            ++at;
+            auto repeated = node{node::kind::repeat};
+            repeated.min = min;
+            repeated.max = max;
+            if (not done() and peek() == '?') {
+                repeated.greedy = false;
+                ++at;
+            }
+            if (not done() and (peek() == '*' or peek() == '+' or peek() == '?' or peek() == '{')) {
+                fail("nothing to repeat", at);
+            }
+            repeated.children.push_back(std::move(operand));
+            return repeated;
+        }
+
+        auto number() -> int {
+            const auto first = at;
+            auto value = 0;
+            while (not done() and peek() >= '0' and peek() <= '9') {
+                value = value * 10 + (peek() - '0');
+                if (value > max_repeat) {
+                    fail("repetition count above 1000", first);
+                }
+                ++at;
+            }
+            if (at == first) {
+                fail("expected a repetition count", at);
+            }
+            return value;
+        }
+
+        auto atom() -> node {
+            const auto c = peek();
+            switch (c) {
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                fail("nothing to repeat", at);
+            case '(': {
+                const auto open = at++;
+                if (pattern.substr(at, 2) == "?:") {
+                    at += 2;
+                }
+                auto group = alternation();
+                if (done() or peek() != ')') {
+                    fail("unmatched (", open);
+                }
+                ++at;
+                return group;
+            }
+            case '[':
+                return set_node(bracket());
+            case '.':
+                ++at;
+                return set_node(~fsv::byte_set::of("\n"));
+            case '^':
+                ++at;
+                return node{node::kind::begin};
+            case '$':
+                ++at;
+                return node{node::kind::end};
+            case '\\':
+                ++at;
+                return set_node(escape(false));
+            default:
+                break;
+            }
+            ++at;
+            return set_node(fsv::byte_set{}.insert(c));
+        }
+
+        static auto set_node(fsv::byte_set set) -> node {
+            auto leaf = node{node::kind::set};
+            leaf.set = set;
+            return leaf;
+        }
+
+        // After a backslash: a class escape, a control escape or a literal punctuation char
+        auto escape(bool in_bracket) -> fsv::byte_set {
+            if (done()) {
+                fail("trailing backslash", at);
+            }
+            const auto c = pattern[at++];
+            switch (c) {
+            case 'd': return fsv::pred::digit;
+            case 'D': return ~fsv::pred::digit;
+            case 'w': return word;
+            case 'W': return ~word;
+            case 's': return fsv::pred::space;
+            case 'S': return ~fsv::pred::space;
+            case 'n': return fsv::byte_set::of("\n");
+            case 'r': return fsv::byte_set::of("\r");
+            case 't': return fsv::byte_set::of("\t");
+            case 'f': return fsv::byte_set::of("\f");
+            case 'v': return fsv::byte_set::of("\v");
+            case '0': return fsv::byte_set{}.insert('\0');
+            case 'x': {
+                auto value = 0u;
+                for (auto digits = 0; digits < 2; ++digits, ++at) {
+                    if (done() or not fsv::pred::xdigit.contains(peek())) {
+                        fail("\\x needs two hex digits", at);
+                    }
+                    const auto d = peek();
+                    value = value * 16 + static_cast<unsigned>(d <= '9' ? d - '0' : (d | 0x20) - 'a' + 10);
+                }
+                return fsv::byte_set{}.insert(static_cast<char>(value));
+            }
+            default:
+                break;
+            }
+            if (fsv::pred::alnum.contains(c) and not (in_bracket and c == 'b')) {
+                fail("unsupported escape", at - 2);
+            }
+            // [\b] is a backspace, as in ECMAScript
+            return fsv::byte_set{}.insert(c == 'b' ? '\b' : c);
+        }
+
+        auto bracket() -> fsv::byte_set {
+            const auto open = at++;
+            const auto negated = not done() and peek() == '^';
+            if (negated) {
+                ++at;
+            }
+            auto set = fsv::byte_set{};
+            auto first = true;
+            while (not done() and (peek() != ']' or first)) {
+                first = false;
+                // A single char, or a class escape that cannot start a range
+                auto low = pattern[at];
+                auto item = fsv::byte_set{};
+                if (low == '\\') {
+                    ++at;
+                    item = escape(true);
+                    if (item.count() != 1) {
+                        set = set | item;
+                        continue;
+                    }
+                    low = first_member(item);
+                }
+                else {
+                    ++at;
+                }
+                if (at + 1 < pattern.size() and peek() == '-' and pattern[at + 1] != ']') {
+                    ++at;
+                    auto high = pattern[at++];
+                    if (high == '\\') {
+                        const auto bound = escape(true);
+                        if (bound.count() != 1) {
+                            fail("class escape as a range bound", at);
+                        }
+                        high = first_member(bound);
+                    }
+                    if (static_cast<unsigned char>(high) < static_cast<unsigned char>(low)) {
+                        fail("range out of order", at);
+                    }
+                    set = set | fsv::byte_set::range(low, high);
+                }
+                else {
+                    set = set | fsv::byte_set{}.insert(low);
+                }
+            }
+            if (done()) {
+                fail("unmatched [", open);
+            }
+            ++at;
+            return negated ? ~set : set;
+        }
+
+        static auto first_member(const fsv::byte_set &set) -> char {
+            for (unsigned b = 0; b < 256; ++b) {
+                if (set.contains(static_cast<char>(b))) {
+                    return static_cast<char>(b);
+                }
+            }
+            return '\0';
+        }
+
+        std::string_view pattern;
+        std::size_t at = 0;
+        std::size_t depth = 0;
+    };
+
+    // Emits code that matches n and then continues at next, and returns its entry.
+    // Built back to front, so every successor already exists. A reversed program
+    // matches the reversed strings: sequences run backwards and ^ and $ swap.
+    class compiler {
+    public:
+        explicit compiler(bool reversed)
+            : reversed(reversed)
+        {
+            result.code.push_back({op::match});
+        }
+
+        auto compile(const node &root) -> program {
+            result.start = emit(root, 0);
+            return std::move(result);
+        }
+
+    private:
+        auto add(program::instruction instruction) -> std::uint32_t {
+            if (result.code.size() == max_instructions) {
+                throw std::domain_error{"fsv::regex: pattern too large"};
+            }
+            result.code.push_back(instruction);
+            return static_cast<std::uint32_t>(result.code.size() - 1);
+        }
+
+        auto emit(const node &n, std::uint32_t next) -> std::uint32_t {
+            switch (n.type) {
+            case node::kind::set:
+                return add({op::byte_class, next, 0, n.set});
+            case node::kind::begin:
+                return add({reversed ? op::assert_end : op::assert_begin, next});
+            case node::kind::end:
+                return add({reversed ? op::assert_begin : op::assert_end, next});
+            case node::kind::concat:
+                if (reversed) {
+                    for (const auto &child : n.children) {
+                        next = emit(child, next);
+                    }
+                }
+                else {
+                    for (auto child = n.children.rbegin(); child != n.children.rend(); ++child) {
+                        next = emit(*child, next);
+                    }
+                }
+                return next;
+            case node::kind::alternate: {
+                // The parser only makes alternations of two or more branches; each
+                // split prefers the earlier one
+                auto entry = emit(n.children[n.children.size() - 1], next);
+                for (auto i = n.children.size() - 1; i > 0; --i) {
+                    entry = add({op::split, emit(n.children[i - 1], next), entry});
+                }
+                return entry;
+            }
+            case node::kind::repeat:
+                break;
+            }
+
+            const auto &body = n.children.front();
+            auto entry = next;
+            if (n.max == unbounded) {
+                const auto loop = add({op::split});
+                const auto body_entry = emit(body, loop);
+                result.code[loop].next = n.greedy ? body_entry : next;
+                result.code[loop].alt = n.greedy ? next : body_entry;
+                entry = loop;
+            }
+            else {
+                for (auto optional = n.min; optional < n.max; ++optional) {
+                    const auto body_entry = emit(body, entry);
+                    entry = n.greedy ? add({op::split, body_entry, next}) : add({op::split, next, body_entry});
+                }
+            }
+            for (auto required = 0; required < n.min; ++required) {
+                entry = emit(body, entry);
+            }
+            return entry;
+        }
+
+        bool reversed;
+        program result;
+    };
+}
+
+auto fsv::detail::lazy_dfa::list_hash::operator()(const std::vector<std::uint32_t> &list) const -> std::size_t {
+    return content_hash(std::string_view(reinterpret_cast<const char *>(list.data()), list.size() * sizeof(std::uint32_t)));
+}
+
+fsv::detail::lazy_dfa::lazy_dfa(regex_program program, bool leftmost_first, std::size_t max_states)
+    : program(std::move(program)),
+      leftmost_first(leftmost_first),
+      max_states(max_states),
+      visited(this->program.code.size(), 0)
+{
+    // Alphabet compression: bytes that every byte_class treats alike share a column
+    for (const auto &instruction : this->program.code) {
+        if (instruction.code != regex_program::op::byte_class) {
+            continue;
+        }
+        auto split_column = std::vector<std::uint16_t>(classes * 2, UINT16_MAX);
+        auto split_classes = std::size_t{0};
+        for (unsigned b = 0; b < 256; ++b) {
+            auto &column = split_column[column_of[b] * 2u + (instruction.set.contains(static_cast<char>(b)) ? 1u : 0u)];
+            if (column == UINT16_MAX) {
+                column = static_cast<std::uint16_t>(split_classes++);
+            }
+            column_of[b] = column;
+        }
+        classes = split_classes;
+    }
+    flush();
+}
+
+auto fsv::detail::lazy_dfa::flush() -> void {
+    if (not lists.empty()) {
+        ++flushes;
+    }
+    ids.clear();
+    lists.clear();
+    flags.clear();
+    table.clear();
+    starts.fill(unknown);
+    intern({});
+}
+
+auto fsv::detail::lazy_dfa::start(bool at_begin, bool unanchored) -> std::uint32_t {
+    auto &cached = starts[(at_begin ? 2u : 0u) + (unanchored ? 1u : 0u)];
+    if (cached == unknown) {
+        auto list = std::vector<std::uint32_t>{};
+        ++generation;
+        if (follow(program.start, at_begin, false, list) and unanchored) {
+            list.push_back(restart);
+        }
+        if (not leftmost_first) {
+            std::sort(list.begin(), list.end());
+        }
+        const auto state = intern(std::move(list));
+        // intern may have flushed the cache, starts included
+        starts[(at_begin ? 2u : 0u) + (unanchored ? 1u : 0u)] = state;
+        return state;
+    }
+    return cached;
+}
+
+// Appends to list the consuming threads, $ assertions and matches reachable from pc
+// without consuming a char, in priority order. In leftmost-first mode it stops at
+// a match and returns false: everything after it is cut.
+auto fsv::detail::lazy_dfa::follow(std::uint32_t pc, bool at_begin, bool at_end, std::vector<std::uint32_t> &list)
+    -> bool {
+    stack.push_back(pc);
+    while (not stack.empty()) {
+        pc = stack.back();
+        stack.pop_back();
+        if (visited[pc] == generation) {
+            continue;
+        }
+        visited[pc] = generation;
+        const auto &instruction = program.code[pc];
+        switch (instruction.code) {
+        case regex_program::op::split:
+            stack.push_back(instruction.alt);
+            stack.push_back(instruction.next);
+            break;
+        case regex_program::op::assert_begin:
+            if (at_begin) {
+                stack.push_back(instruction.next);
+            }
+            break;
+        case regex_program::op::assert_end:
+            if (at_end) {
+                stack.push_back(instruction.next);
+            }
+            else {
+                list.push_back(pc);
+            }
+            break;
+        case regex_program::op::match:
+            list.push_back(pc);
+            if (leftmost_first) {
+                stack.clear();
+                return false;
+            }
+            break;
+        case regex_program::op::byte_class:
+            list.push_back(pc);
+            break;
+        }
+    }
+    return true;
+}
+
+auto fsv::detail::lazy_dfa::transition(std::uint32_t state, char c) -> std::uint32_t {
+    auto list = std::vector<std::uint32_t>{};
+    ++generation;
+    for (auto entry : *lists[state]) {
+        if (entry == restart) {
+            if (follow(program.start, false, false, list)) {
+                list.push_back(restart);
+            }
+            break;
+        }
+        const auto &instruction = program.code[entry];
+        if (instruction.code == regex_program::op::byte_class and instruction.set.contains(c)
+            and not follow(instruction.next, false, false, list))
+        {
+            break;
+        }
+    }
+    if (not leftmost_first) {
+        std::sort(list.begin(), list.end());
+    }
+    const auto flushes_before = flushes;
+    const auto next_state = intern(std::move(list));
+    if (flushes == flushes_before) {
+        table[state * classes + column_of[static_cast<unsigned char>(c)]] = next_state;
+    }
+    return next_state;
+}
+
+auto fsv::detail::lazy_dfa::intern(std::vector<std::uint32_t> list) -> std::uint32_t {
+    if (auto found = ids.find(list); found != ids.end()) {
+        return found->second;
+    }
+    if (lists.size() == max_states) {
+        flush();
+    }
+
+    std::uint8_t state_flags = 0;
+    ++generation;
+    auto at_end = std::vector<std::uint32_t>{};
+    for (auto entry : list) {
+        if (entry == restart) {
+            break;
+        }
+        const auto code = program.code[entry].code;
+        if (code == regex_program::op::match) {
+            state_flags |= match_flag | end_match_flag;
+        }
+        else if (code == regex_program::op::assert_end) {
+            follow(program.code[entry].next, false, true, at_end);
+        }
+    }
+    if (std::find(at_end.begin(), at_end.end(), 0) != at_end.end()) {
+        state_flags |= end_match_flag;
+    }
+
+    const auto id = static_cast<std::uint32_t>(lists.size());
+    const auto inserted = ids.emplace(std::move(list), id).first;
+    lists.push_back(&inserted->first);
+    flags.push_back(state_flags);
+    table.resize(table.size() + classes, unknown);
+    return id;
+}
+
+auto fsv::regex::compile(std::string_view pattern, std::size_t max_states) -> programs {
+    if (max_states < 4) {
+        throw std::domain_error{"fsv::regex: max_states must be at least 4"};
+    }
+    const auto root = parser(pattern).parse();
+    return {compiler(false).compile(root), compiler(true).compile(root)};
+}
+
+fsv::regex::regex(std::string_view pattern, std::size_t max_states)
+    : regex(compile(pattern, max_states), max_states)
+{
+
+}
+
+fsv::regex::regex(programs compiled, std::size_t max_states)
+    : forward(compiled.first, true, max_states),
+      forward_longest(std::move(compiled.first), false, max_states),
+      backward(std::move(compiled.second), false, max_states)
+{
+
+}
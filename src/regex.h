@@ -0,0 +1,338 @@
+#ifndef COMP6771_ASS2_REGEX_H
+#define COMP6771_ASS2_REGEX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./filtered_string_view.h"
+
+namespace fsv {
+	namespace detail {
+		/**
+		 * A Thompson NFA: instruction 0 is the match, start is the entry point.
+		 */
+		struct regex_program {
+			enum class op : std::uint8_t { match, byte_class, split, assert_begin, assert_end };
+
+			struct instruction {
+				op code;
+				// The successor; for a split the preferred one
+				std::uint32_t next = 0;
+				// The other successor of a split
+				std::uint32_t alt = 0;
+				// The bytes a byte_class consumes
+				byte_set set{};
+			};
+
+			std::vector<instruction> code;
+			std::uint32_t start = 0;
+		};
+
+		/**
+		 * A DFA over a regex_program whose states are built on first use.
+		 *
+		 * A state is the list of NFA threads alive at a position. In leftmost-first
+		 * mode the list is in priority order and everything after a match is cut, so
+		 * higher priority threads may still extend the match (greedy repetition,
+		 * earlier alternatives) while lower priority ones, new starts included, may not.
+		 * In longest mode nothing is cut and the list is kept sorted.
+		 *
+		 * At most max_states states are cached. When a new state does not fit, the
+		 * whole cache is dropped and rebuilt from the states the scan goes on to
+		 * visit, so memory stays bounded whatever the pattern and the input.
+		 */
+		class lazy_dfa {
+		public:
+			static constexpr std::uint32_t dead = 0;
+
+			lazy_dfa(regex_program program, bool leftmost_first, std::size_t max_states);
+
+			/**
+			 * The state before the first char. at_begin says whether ^ holds there,
+			 * unanchored whether a new match may also start at every later position.
+			 */
+			auto start(bool at_begin, bool unanchored) -> std::uint32_t;
+
+			auto next(std::uint32_t state, char c) -> std::uint32_t {
+				const auto next_state = table[state * classes + column_of[static_cast<unsigned char>(c)]];
+				return next_state != unknown ? next_state : transition(state, c);
+			}
+
+			/**
+			 * Whether a match ends at the position the state was reached at
+			 */
+			auto is_match(std::uint32_t state) const -> bool {
+				return (flags[state] & match_flag) != 0;
+			}
+
+			/**
+			 * Whether a match ends there if it is also the end of the text, so $ holds
+			 */
+			auto accepts_at_end(std::uint32_t state) const -> bool {
+				return (flags[state] & end_match_flag) != 0;
+			}
+
+			auto state_count() const -> std::size_t {
+				return lists.size();
+			}
+
+			auto flush_count() const -> std::size_t {
+				return flushes;
+			}
+
+		private:
+			static constexpr std::uint32_t unknown = UINT32_MAX;
+			// List entry standing for the threads that start at later positions
+			static constexpr std::uint32_t restart = UINT32_MAX;
+			static constexpr std::uint8_t match_flag = 1;
+			static constexpr std::uint8_t end_match_flag = 2;
+
+			struct list_hash {
+				auto operator()(const std::vector<std::uint32_t> &list) const -> std::size_t;
+			};
+
+			auto transition(std::uint32_t state, char c) -> std::uint32_t;
+			auto follow(std::uint32_t pc, bool at_begin, bool at_end, std::vector<std::uint32_t> &list) -> bool;
+			auto intern(std::vector<std::uint32_t> list) -> std::uint32_t;
+			auto flush() -> void;
+
+			regex_program program;
+			bool leftmost_first;
+			std::size_t max_states;
+			std::array<std::uint16_t, 256> column_of{};
+			std::size_t classes = 1;
+
+			std::unordered_map<std::vector<std::uint32_t>, std::uint32_t, list_hash> ids;
+			// lists[s]: the thread list of state s, a key of ids
+			std::vector<const std::vector<std::uint32_t> *> lists;
+			std::vector<std::uint8_t> flags;
+			// table[s * classes + class]: the next state, or unknown until first taken
+			std::vector<std::uint32_t> table;
+			// Start states by at_begin * 2 + unanchored
+			std::array<std::uint32_t, 4> starts{unknown, unknown, unknown, unknown};
+			std::size_t flushes = 0;
+
+			// Scratch space for follow()
+			std::vector<std::uint32_t> stack;
+			std::vector<std::uint32_t> visited;
+			std::uint32_t generation = 0;
+		};
+	} // namespace detail
+
+	struct regex_match {
+		// Filtered offset of the first char of the match
+		std::size_t offset;
+		// Number of filtered chars matched
+		std::size_t length;
+
+		friend auto operator==(const regex_match &, const regex_match &) -> bool = default;
+	};
+
+	/**
+	 * A regular expression matched against the passing chars of a view, in time
+	 * linear in their number and without backtracking.
+	 *
+	 * Syntax is the ECMAScript subset of std::regex without captures or lookaround:
+	 * literals and escapes, ., [classes] with ranges and negation, \d \w \s \D \W \S,
+	 * (?:) and () grouping, |, * + ? {n} {n,} {n,m} and their lazy forms, ^ and $
+	 * (which hold at the start and end of the view). Matches are leftmost-first, as
+	 * with std::regex, and offsets are filtered offsets like operator[] indexes.
+	 *
+	 *   auto version = fsv::regex{"v[0-9]+(\\.[0-9]+)*"};
+	 *   auto found = version.search(fsv::filtered_string_view{banner, no_space});
+	 *
+	 * A forward DFA finds where the match ends, a DFA of the reversed pattern
+	 * run backwards from there finds where it starts. Both are built lazily with at
+	 * most max_states cached states each. Like the cached size of a view, the caches
+	 * are not synchronised: one regex must not be used by two threads at once.
+	 */
+	class regex {
+	public:
+		/**
+		 * Throws std::domain_error on a syntax error, a repetition count above 1000,
+		 * or max_states below 4
+		 */
+		explicit regex(std::string_view pattern, std::size_t max_states = 4096);
+
+		/**
+		 * Whether the whole filtered string matches
+		 */
+		template<typename Pred>
+		auto matches(const basic_filtered_string_view<Pred> &view) const -> bool;
+
+		/**
+		 * The leftmost match starting at filtered offset pos or later
+		 */
+		template<typename Pred>
+		auto search(const basic_filtered_string_view<Pred> &view, std::size_t pos = 0) const
+		    -> std::optional<regex_match> {
+			const auto from = view.skip_passing(pos);
+			if (from == nullptr) {
+				return std::nullopt;
+			}
+			if (auto found = search_from(view, pos, from)) {
+				return found->match;
+			}
+			return std::nullopt;
+		}
+
+		/**
+		 * Every non-overlapping match, left to right. After an empty match the next
+		 * search starts one char further on.
+		 */
+		template<typename Pred>
+		auto find_all(const basic_filtered_string_view<Pred> &view) const -> std::vector<regex_match>;
+
+		/**
+		 * Number of DFA states cached at the moment, over the forward and reverse DFAs
+		 */
+		auto cached_states() const -> std::size_t {
+			return forward.state_count() + forward_longest.state_count() + backward.state_count();
+		}
+
+		/**
+		 * How many times a full cache had to be dropped
+		 */
+		auto cache_flushes() const -> std::size_t {
+			return forward.flush_count() + forward_longest.flush_count() + backward.flush_count();
+		}
+
+	private:
+		// The pattern compiled forwards and reversed
+		using programs = std::pair<detail::regex_program, detail::regex_program>;
+
+		static auto compile(std::string_view pattern, std::size_t max_states) -> programs;
+
+		regex(programs compiled, std::size_t max_states);
+
+		struct located {
+			regex_match match;
+			// One past the last byte of the match in the view's buffer
+			const char *end;
+		};
+
+		template<typename Pred>
+		auto search_from(const basic_filtered_string_view<Pred> &view, std::size_t pos, const char *from) const
+		    -> std::optional<located>;
+
+		// Leftmost-first and unanchored, for where matches end
+		mutable detail::lazy_dfa forward;
+		// Longest and anchored, for matches()
+		mutable detail::lazy_dfa forward_longest;
+		// The reversed pattern, longest and anchored, for where matches start
+		mutable detail::lazy_dfa backward;
+	};
+
+	template<typename Pred>
+	auto regex::matches(const basic_filtered_string_view<Pred> &view) const -> bool {
+		auto state = forward_longest.start(true, false);
+		view.with_predicate([&](const auto &pred) {
+			auto chunks = detail::chunk_reader{view.window_first, view.window_last, pred};
+			for (auto chunk = chunks.next(); not chunk.empty(); chunk = chunks.next()) {
+				for (auto c : chunk) {
+					state = forward_longest.next(state, c);
+					if (state == detail::lazy_dfa::dead) {
+						return;
+					}
+				}
+			}
+		});
+		return forward_longest.accepts_at_end(state);
+	}
+
+	template<typename Pred>
+	auto regex::search_from(const basic_filtered_string_view<Pred> &view, std::size_t pos, const char *from) const
+	    -> std::optional<located> {
+		constexpr auto none = static_cast<std::size_t>(-1);
+		auto state = forward.start(pos == 0, true);
+		auto end = forward.is_match(state) ? pos : none;
+		auto offset = pos;
+		auto reached_end = false;
+		view.with_predicate([&](const auto &pred) {
+			auto chunks = detail::chunk_reader{from, view.window_last, pred};
+			for (auto chunk = chunks.next(); not chunk.empty(); chunk = chunks.next()) {
+				for (auto c : chunk) {
+					state = forward.next(state, c);
+					++offset;
+					if (state == detail::lazy_dfa::dead) {
+						return;
+					}
+					if (forward.is_match(state)) {
+						end = offset;
+					}
+				}
+			}
+			reached_end = true;
+			if (forward.accepts_at_end(state)) {
+				end = offset;
+			}
+		});
+		if (end == none) {
+			return std::nullopt;
+		}
+
+		auto end_position = from;
+		if (auto set = view.byte_class(); set and set->is_all()) {
+			end_position += end - pos;
+		}
+		else {
+			for (auto count = end - pos; count > 0; --count) {
+				end_position = view.next_passing(end_position) + 1;
+			}
+		}
+
+		// Walk back from the end for the leftmost start; one exists at or after pos
+		auto back = backward.start(reached_end and end == offset, false);
+		auto start = backward.is_match(back) ? end : none;
+		auto position = end_position;
+		auto index = end;
+		while (index > pos) {
+			// index > pos passing chars lie before position, so there is always one
+			position = view.last_passing_before(position);
+			if (position == nullptr) {
+				break;
+			}
+			back = backward.next(back, *position);
+			--index;
+			if (back == detail::lazy_dfa::dead) {
+				break;
+			}
+			if (backward.is_match(back)) {
+				start = index;
+			}
+		}
+		if (index == 0 and back != detail::lazy_dfa::dead and backward.accepts_at_end(back)) {
+			start = 0;
+		}
+		return located{regex_match{start, end - start}, end_position};
+	}
+
+	template<typename Pred>
+	auto regex::find_all(const basic_filtered_string_view<Pred> &view) const -> std::vector<regex_match> {
+		auto found = std::vector<regex_match>{};
+		auto pos = std::size_t{0};
+		auto from = view.window_first;
+		while (auto next = search_from(view, pos, from)) {
+			found.push_back(next->match);
+			pos = next->match.offset + next->match.length;
+			from = next->end;
+			if (next->match.length == 0) {
+				from = view.next_passing(from);
+				if (from == view.window_last) {
+					break;
+				}
+				++from;
+				++pos;
+			}
+		}
+		return found;
+	}
+} // namespace fsv
+
+#endif // COMP6771_ASS2_REGEX_H
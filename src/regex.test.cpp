@@ -0,0 +1,115 @@
+#include "./regex.h"
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+	// The leftmost match of std::regex on the materialised string, the reference semantics
+	auto reference_search(const std::regex &pattern, const std::string &text) -> std::optional<fsv::regex_match> {
+		auto found = std::smatch{};
+		if (not std::regex_search(text, found, pattern)) {
+			return std::nullopt;
+		}
+		return fsv::regex_match{static_cast<std::size_t>(found.position(0)), static_cast<std::size_t>(found.length(0))};
+	}
+}
+
+TEST_CASE("Regex") {
+	const auto no_dash = [](const char &c) { return c != '-'; };
+
+	SECTION("Matches the filtered string") {
+		const auto number = fsv::regex{"[+-]?[0-9]+(\\.[0-9]+)?"};
+		CHECK(number.matches(fsv::filtered_string_view{"3.25"}));
+		CHECK(not number.matches(fsv::filtered_string_view{"3.25x"}));
+		CHECK(not number.matches(fsv::filtered_string_view{"3."}));
+
+		const auto word = fsv::regex{"^abc$"};
+		CHECK(word.matches(fsv::filtered_string_view{"a-b--c-", no_dash}));
+		CHECK(not word.matches(fsv::filtered_string_view{"a-b--cc", no_dash}));
+		CHECK(fsv::regex{"a|ab"}.matches(fsv::filtered_string_view{"ab"}));
+		CHECK(fsv::regex{"x*"}.matches(fsv::filtered_string_view{""}));
+	}
+
+	SECTION("Search returns filtered offsets") {
+		const auto view = fsv::filtered_string_view{"id-: a-b-12, c-d-345", no_dash};
+		const auto digits = fsv::regex{"[0-9]+"};
+		// The filtered string is "id: ab12, cd345"
+		CHECK(digits.search(view) == fsv::regex_match{6, 2});
+		CHECK(digits.search(view, 7) == fsv::regex_match{7, 1});
+		CHECK(digits.search(view, 8) == fsv::regex_match{12, 3});
+		CHECK(digits.search(view, 14) == fsv::regex_match{14, 1});
+		CHECK(not digits.search(view, 15));
+		CHECK(not digits.search(view, 16));
+		CHECK(fsv::regex{"\\w+$"}.search(view) == fsv::regex_match{10, 5});
+		CHECK(fsv::regex{"^\\w+"}.search(view, 1) == std::nullopt);
+
+		const auto statically = fsv::basic_filtered_string_view{"ab-ab-abb", ~fsv::byte_set::of("-")};
+		CHECK(fsv::regex{"(ab)+b"}.search(statically) == fsv::regex_match{0, 7});
+		CHECK(fsv::regex{"(ab)+?"}.search(statically) == fsv::regex_match{0, 2});
+	}
+
+	SECTION("Find all") {
+		const auto view = fsv::filtered_string_view{"a1 b22 c333"};
+		const auto expected = std::vector<fsv::regex_match>{{1, 1}, {4, 2}, {8, 3}};
+		CHECK(fsv::regex{"\\d+"}.find_all(view) == expected);
+		const auto empties = std::vector<fsv::regex_match>{{0, 0}, {1, 1}, {2, 0}};
+		CHECK(fsv::regex{"b*"}.find_all(fsv::filtered_string_view{"ab"}) == empties);
+	}
+
+	SECTION("Syntax errors") {
+		CHECK_THROWS_AS(fsv::regex{"(ab"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"ab)"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"*a"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"a**"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"[a"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"[z-a]"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"a{3,2}"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"a{1001}"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex{"\\q"}, std::domain_error);
+		CHECK_THROWS_AS(fsv::regex("a", 3), std::domain_error);
+	}
+
+	SECTION("Agrees with std::regex") {
+		const auto patterns = std::vector<std::string>{
+		    "ab", "a|ab", "ab|a", "a*b", "(a|b)*c", "(ab)+", "a+?b", "[^a]+", "b{2,3}", "c{2,}",
+		    "^a", "b$", "^(a|b)*$", "(a|ab)(c|bcd)", "a(b|c)*?c", "\\w\\s?c", ".b.", "(?:ab|ba)+c?"};
+		auto generator = std::mt19937{7};
+		auto texts = std::vector<std::string>(300);
+		for (auto &text : texts) {
+			text.resize(generator() % 24);
+			for (auto &c : text) {
+				c = "abc -"[generator() % 5];
+			}
+		}
+		for (const auto &pattern : patterns) {
+			const auto engine = fsv::regex{pattern};
+			const auto reference = std::regex{pattern};
+			for (const auto &text : texts) {
+				const auto view = fsv::filtered_string_view{text, no_dash};
+				const auto filtered = static_cast<std::string>(view);
+				INFO(pattern << " on \"" << filtered << "\"");
+				REQUIRE(engine.search(view) == reference_search(reference, filtered));
+				REQUIRE(engine.matches(view) == std::regex_match(filtered, reference));
+			}
+		}
+	}
+
+	SECTION("Bounded state cache") {
+		// (a|b)*a(a|b){6} needs 2^7 DFA states, far more than the cache may hold
+		const auto engine = fsv::regex{"(a|b)*a(a|b){6}$", 16};
+		auto generator = std::mt19937{11};
+		auto text = std::string(5000, 'a');
+		for (auto &c : text) {
+			c = generator() % 2 ? 'a' : 'b';
+		}
+		text[text.size() - 7] = 'a';
+		CHECK(engine.search(fsv::filtered_string_view{text}) == fsv::regex_match{0, text.size()});
+		text[text.size() - 7] = 'b';
+		CHECK(not engine.search(fsv::filtered_string_view{text}));
+		CHECK(engine.cached_states() <= 3 * 16);
+		CHECK(engine.cache_flushes() > 0);
+	}
+}
@@ -0,0 +1,169 @@
+#include "./two_way.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    // Start (minus one) of the maximal suffix of x[0, m) for the byte order, or for the
+    // reversed order, together with the period of that suffix
+    template<typename Needle>
+    auto maximal_suffix(Needle x, std::ptrdiff_t m, bool reversed, std::ptrdiff_t &period) -> std::ptrdiff_t {
+        std::ptrdiff_t suffix = -1;
+        std::ptrdiff_t j = 0;
+        std::ptrdiff_t k = 1;
+        period = 1;
+        while (j + k < m) {
+            const auto a = x(j + k);
+            const auto b = x(suffix + k);
+            if (reversed ? a > b : a < b) {
+                j += k;
+                k = 1;
+                period = j - suffix;
+            }
+            else if (a == b) {
+                if (k != period) {
+                    ++k;
+                }
+                else {
+                    j += period;
+                    k = 1;
+                }
+            }
+            else {
+                suffix = j;
+                j = suffix + 1;
+                k = 1;
+                period = 1;
+            }
+        }
+        return suffix;
+    }
+
+    template<typename Needle>
+    auto factorise(Needle x, std::ptrdiff_t m) -> fsv::detail::two_way::factorisation {
+        std::ptrdiff_t forward_period = 1;
+        std::ptrdiff_t reversed_period = 1;
+        const auto forward = maximal_suffix(x, m, false, forward_period);
+        const auto reversed = maximal_suffix(x, m, true, reversed_period);
+        auto result = fsv::detail::two_way::factorisation{};
+        result.split = std::max(forward, reversed);
+        result.period = forward > reversed ? forward_period : reversed_period;
+
+        result.periodic = result.period < m;
+        for (std::ptrdiff_t i = 0; result.periodic and i <= result.split; ++i) {
+            result.periodic = x(i) == x(i + result.period);
+        }
+        if (not result.periodic) {
+            result.period = std::max(result.split + 1, m - result.split - 1) + 1;
+        }
+        return result;
+    }
+
+    // First j in [0, n - m] where x occurs at y(j), or -1. skip(j) is the first
+    // candidate at or after j where y(j) == x(0), or -1 if there is none.
+    template<typename Needle, typename Text, typename Skip>
+    auto search(Needle x,
+                std::ptrdiff_t m,
+                Text y,
+                std::ptrdiff_t n,
+                const fsv::detail::two_way::factorisation &factors,
+                Skip skip) -> std::ptrdiff_t {
+        const auto [split, period, periodic] = factors;
+        std::ptrdiff_t j = 0;
+        // Prefix of the needle known to match at j from the previous attempt, -1 for none
+        std::ptrdiff_t memory = -1;
+        while (j <= n - m) {
+            if (memory < 0) {
+                j = skip(j);
+                if (j < 0) {
+                    return -1;
+                }
+            }
+            auto i = std::max(split, memory) + 1;
+            while (i < m and x(i) == y(i + j)) {
+                ++i;
+            }
+            if (i < m) {
+                j += i - split;
+                memory = -1;
+                continue;
+            }
+            i = split;
+            while (i > memory and x(i) == y(i + j)) {
+                --i;
+            }
+            if (i <= memory) {
+                return j;
+            }
+            j += period;
+            memory = periodic ? m - period - 1 : -1;
+        }
+        return -1;
+    }
+
+    // Last occurrence of c in [first, last), or nullptr
+    auto find_last_byte(const char *first, const char *last, char c) -> const char * {
+#ifdef __GLIBC__
+        return static_cast<const char *>(::memrchr(first, c, static_cast<std::size_t>(last - first)));
+#else
+        while (last != first) {
+            if (*--last == c) {
+                return last;
+            }
+        }
+        return nullptr;
+#endif
+    }
+} // namespace
+
+fsv::detail::two_way::two_way(std::string_view needle)
+    : needle(needle)
+{
+    const auto m = static_cast<std::ptrdiff_t>(needle.size());
+    const auto x = needle.data();
+    forward = factorise([x](std::ptrdiff_t i) { return static_cast<unsigned char>(x[i]); }, m);
+    backward = factorise([x, m](std::ptrdiff_t i) { return static_cast<unsigned char>(x[m - 1 - i]); }, m);
+}
+
+auto fsv::detail::two_way::find(const char *first, const char *last) const -> const char * {
+    const auto m = static_cast<std::ptrdiff_t>(needle.size());
+    const auto n = last - first;
+    if (m == 0) {
+        return first;
+    }
+    if (m > n) {
+        return last;
+    }
+    const auto x = needle.data();
+    const auto skip = [=](std::ptrdiff_t j) -> std::ptrdiff_t {
+        auto candidate = static_cast<const char *>(std::memchr(first + j, x[0], static_cast<std::size_t>(n - m - j + 1)));
+        return candidate == nullptr ? -1 : candidate - first;
+    };
+    const auto j = search([x](std::ptrdiff_t i) { return x[i]; }, m, [first](std::ptrdiff_t i) { return first[i]; }, n, forward, skip);
+    return j < 0 ? last : first + j;
+}
+
+auto fsv::detail::two_way::rfind(const char *first, const char *last) const -> const char * {
+    const auto m = static_cast<std::ptrdiff_t>(needle.size());
+    const auto n = last - first;
+    if (m == 0) {
+        return last;
+    }
+    if (m > n) {
+        return last;
+    }
+    // Two-Way over the reversed needle and the reversed text, so the first match
+    // found is the last one, and the search stops there
+    const auto x = needle.data();
+    const auto skip = [=](std::ptrdiff_t j) -> std::ptrdiff_t {
+        auto candidate = find_last_byte(first + m - 1, last - j, x[m - 1]);
+        return candidate == nullptr ? -1 : last - 1 - candidate;
+    };
+    const auto j = search([x, m](std::ptrdiff_t i) { return x[m - 1 - i]; },
+                          m,
+                          [last](std::ptrdiff_t i) { return last[-1 - i]; },
+                          n,
+                          backward,
+                          skip);
+    return j < 0 ? last : last - j - m;
+}
@@ -0,0 +1,54 @@
+#ifndef COMP6771_ASS2_TWO_WAY_H
+#define COMP6771_ASS2_TWO_WAY_H
+
+#include <cstddef>
+#include <string_view>
+
+namespace fsv::detail {
+	/**
+	 * Crochemore-Perrin Two-Way substring search: linear time, constant extra memory.
+	 *
+	 * The needle is split at a critical factorisation once, then every search compares
+	 * the right part forwards and the left part backwards, shifting by the period.
+	 * Whenever nothing is remembered from the previous attempt, the search jumps to
+	 * the next occurrence of the needle's first byte with memchr, which is vectorised.
+	 * rfind runs the same search over the reversed needle and text, with its own
+	 * factorisation, so it stops at the last occurrence instead of scanning past it.
+	 *
+	 * Holds a view of the needle, which must outlive the searcher.
+	 */
+	class two_way {
+	public:
+		explicit two_way(std::string_view needle);
+
+		/**
+		 * Start of the first occurrence of the needle in [first, last), or last
+		 */
+		auto find(const char *first, const char *last) const -> const char *;
+
+		/**
+		 * Start of the last occurrence of the needle in [first, last), or last
+		 */
+		auto rfind(const char *first, const char *last) const -> const char *;
+
+		auto size() const -> std::size_t {
+			return needle.size();
+		}
+
+		struct factorisation {
+			// Last index of the left part of the critical factorisation, -1 if it is empty
+			std::ptrdiff_t split;
+			std::ptrdiff_t period;
+			// Whether the left part repeats in the right one, i.e. period is the needle's period
+			bool periodic;
+		};
+
+	private:
+		std::string_view needle;
+		// Of the needle, and of the needle read backwards
+		factorisation forward;
+		factorisation backward;
+	};
+} // namespace fsv::detail
+
+#endif // COMP6771_ASS2_TWO_WAY_H